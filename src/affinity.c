@@ -0,0 +1,230 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <sched.h>
+#include <dirent.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "affinity.h"
+
+void affinity_init(affinity *a, int mode, bool whole_node)
+{
+    a->mode = mode;
+    a->whole_node = whole_node;
+    a->n_cpus = 0;
+    a->n_nodes = 1;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(cpu_set_t), &allowed);
+    const int n = CPU_COUNT(&allowed);
+    int *cpus = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    int *nodes = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    for (int cpu = 0; cpu < CPU_SETSIZE && a->n_cpus < n; ++cpu)
+    {
+        if (CPU_ISSET(cpu, &allowed))
+        {
+            cpus[a->n_cpus] = cpu;
+            nodes[a->n_cpus] = affinity_find_node(cpu);
+            ++a->n_cpus;
+        }
+    }
+#else
+    int *cpus = (int*)malloc(sizeof(int));
+    int *nodes = (int*)malloc(sizeof(int));
+#endif
+    if (a->n_cpus == 0)
+    {
+        cpus[0] = 0;
+        nodes[0] = 0;
+        a->n_cpus = 1;
+    }
+    a->cpus = (int*)malloc(a->n_cpus * sizeof(int));
+    a->nodes = (int*)malloc(a->n_cpus * sizeof(int));
+
+    // The distinct nodes, in increasing order:
+    int max_node = 0;
+    for (int i = 0; i < a->n_cpus; ++i)
+    {
+        if (nodes[i] > max_node)
+        {
+            max_node = nodes[i];
+        }
+    }
+    int *per_node = (int*)calloc(max_node + 1, sizeof(int));
+    for (int i = 0; i < a->n_cpus; ++i)
+    {
+        per_node[nodes[i]]++;
+    }
+    a->n_nodes = 0;
+    for (int node = 0; node <= max_node; ++node)
+    {
+        a->n_nodes += per_node[node] > 0 ? 1 : 0;
+    }
+
+    if (mode == AFFINITY_ROUND_ROBIN)
+    {
+        // One processor of each node in turn:
+        int *taken = (int*)calloc(max_node + 1, sizeof(int));
+        int k = 0;
+        while (k < a->n_cpus)
+        {
+            for (int node = 0; node <= max_node; ++node)
+            {
+                if (taken[node] == per_node[node])
+                {
+                    continue;
+                }
+                // The next processor of the node:
+                int seen = 0;
+                for (int i = 0; i < a->n_cpus; ++i)
+                {
+                    if (nodes[i] == node && seen++ == taken[node])
+                    {
+                        a->cpus[k] = cpus[i];
+                        a->nodes[k] = node;
+                        ++k;
+                        break;
+                    }
+                }
+                ++taken[node];
+            }
+        }
+        free(taken);
+    }
+    else
+    {
+        // The processors of each node together:
+        int k = 0;
+        for (int node = 0; node <= max_node; ++node)
+        {
+            for (int i = 0; i < a->n_cpus; ++i)
+            {
+                if (nodes[i] == node)
+                {
+                    a->cpus[k] = cpus[i];
+                    a->nodes[k] = node;
+                    ++k;
+                }
+            }
+        }
+    }
+    free(per_node);
+    free(cpus);
+    free(nodes);
+}
+
+bool affinity_pin(const affinity *a, int thread)
+{
+    if (a->mode == AFFINITY_NONE)
+    {
+        return false;
+    }
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (a->whole_node)
+    {
+        const int node = affinity_node(a, thread);
+        for (int i = 0; i < a->n_cpus; ++i)
+        {
+            if (a->nodes[i] == node)
+            {
+                CPU_SET(a->cpus[i], &set);
+            }
+        }
+    }
+    else
+    {
+        CPU_SET(affinity_cpu(a, thread), &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+int affinity_cpu(const affinity *a, int thread)
+{
+    return a->cpus[thread % a->n_cpus];
+}
+
+int affinity_node(const affinity *a, int thread)
+{
+    return a->nodes[thread % a->n_cpus];
+}
+
+const char *affinity_name(int mode)
+{
+    switch (mode)
+    {
+    case AFFINITY_COMPACT:
+        return "Compact";
+    case AFFINITY_ROUND_ROBIN:
+        return "Round-robin";
+    default:
+        return "None";
+    }
+}
+
+void affinity_print(const affinity *a, int threads, FILE *out)
+{
+    fprintf(out, "  <affinity>\n");
+    fprintf(out, "    <mode>%s</mode>\n", affinity_name(a->mode));
+    fprintf(out, "    <processors>%d</processors>\n", a->n_cpus);
+    fprintf(out, "    <nodes>%d</nodes>\n", a->n_nodes);
+    if (a->mode != AFFINITY_NONE)
+    {
+        fprintf(out, "    <pinned_to>%s</pinned_to>\n", a->whole_node ? "node" : "processor");
+        for (int t = 0; t < threads; ++t)
+        {
+            fprintf(out, "    <thread>\n");
+            fprintf(out, "      <id>%d</id>\n", t);
+            fprintf(out, "      <processor>%d</processor>\n", affinity_cpu(a, t));
+            fprintf(out, "      <node>%d</node>\n", affinity_node(a, t));
+            fprintf(out, "    </thread>\n");
+        }
+    }
+    fprintf(out, "  </affinity>\n");
+}
+
+void affinity_free(affinity *a)
+{
+    free(a->cpus);
+    free(a->nodes);
+}
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions
+
+int affinity_find_node(int cpu)
+{
+#ifdef __linux__
+    // The directory of the processor has a link 'nodeN' to its node:
+    char path[64];
+    sprintf(path, "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR *dir = opendir(path);
+    if (dir == NULL)
+    {
+        return 0;
+    }
+    int node = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9')
+        {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,70 @@
+#ifndef AFFINITY_H_
+#define AFFINITY_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#define AFFINITY_NONE          0
+#define AFFINITY_COMPACT       1
+#define AFFINITY_ROUND_ROBIN   2
+
+/**
+ * Placement of the threads running the simulations on the processors the
+ * process is allowed to use (Linux only, elsewhere the threads are never
+ * pinned).
+ *
+ * AFFINITY_COMPACT fills the NUMA nodes one after the other: the threads
+ * 0, 1, 2... get the processors of the first node, then those of the next
+ * one. AFFINITY_ROUND_ROBIN alternates between the nodes: the thread 't'
+ * gets a processor of the node t % nodes.
+ *
+ * A simulation allocates and initializes its state (species, graph,
+ * statistics) in the thread running it, so once the thread is pinned the
+ * pages come from its node (first-touch). When the simulations have their
+ * own workers (-workers), the threads are pinned to all the processors of
+ * their node instead of one, and the workers they create inherit that set.
+ */
+typedef struct
+{
+    int mode; /** AFFINITY_NONE, AFFINITY_COMPACT or AFFINITY_ROUND_ROBIN. */
+
+    bool whole_node; /** True to pin the threads to all the processors of their node. */
+
+    int n_cpus; /** Number of processors. */
+
+    int *cpus; /** The processors, in the order they are given to the threads. */
+
+    int *nodes; /** The node of each processor of 'cpus'. */
+
+    int n_nodes; /** Number of nodes. */
+}
+affinity;
+
+/** Find the processors and their nodes, and order them for 'mode'. */
+void affinity_init(affinity *a, int mode, bool whole_node);
+
+/** Pin the calling thread, the 'thread'th, and return true if it worked. */
+bool affinity_pin(const affinity *a, int thread);
+
+/** Processor of the 'thread'th thread. */
+int affinity_cpu(const affinity *a, int thread);
+
+/** Node of the 'thread'th thread. */
+int affinity_node(const affinity *a, int thread);
+
+/** Name of the mode (for the output). */
+const char *affinity_name(int mode);
+
+/** Print the mode and the processor and node of the first 'threads' threads. */
+void affinity_print(const affinity *a, int threads, FILE *out);
+
+/** Free the memory. */
+void affinity_free(affinity *a);
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions. You shouldn't need those.
+
+/** Return the node of a processor (0 if unknown). */
+int affinity_find_node(int cpu);
+
+#endif
@@ -0,0 +1,345 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <gsl/gsl_rng.h>
+#include "common.h"
+#include "ivector.h"
+#include "rng.h"
+#include "graph.h"
+#include "utils.h"
+#include "checkpoint.h"
+
+// First bytes of the files.
+static const char checkpoint_magic[8] = { 'O', 'R', 'I', 'G', 'C', 'K', 'P', 'T' };
+
+void checkpoint_init(checkpoint *ck, const char *filename)
+{
+    ck->capacity = 1024;
+    ck->data = (char*)malloc(ck->capacity);
+    ck->size = 0;
+    ck->pos = 0;
+    ck->ok = true;
+    ck->filename = filename != NULL ? strdup(filename) : NULL;
+    ck->pending = NULL;
+    ck->pending_size = 0;
+    ck->pending_capacity = 0;
+    ck->writing = false;
+    ck->failed = false;
+    ck->written = 0;
+    ck->begin_time = 0.0;
+    ck->max_pause = 0.0;
+    ck->write_seconds = 0.0;
+}
+
+void checkpoint_begin(checkpoint *ck)
+{
+    ck->begin_time = seconds_monotonic();
+    ck->size = 0;
+    ck->pos = 0;
+    ck->ok = true;
+}
+
+void checkpoint_put(checkpoint *ck, const void *x, size_t bytes)
+{
+    if (ck->size + bytes > ck->capacity)
+    {
+        while (ck->size + bytes > ck->capacity)
+        {
+            ck->capacity *= VECTOR_GROW_RATE;
+        }
+        ck->data = (char*)realloc(ck->data, ck->capacity);
+    }
+    memcpy(ck->data + ck->size, x, bytes);
+    ck->size += bytes;
+}
+
+void checkpoint_put_int(checkpoint *ck, int x)
+{
+    checkpoint_put(ck, &x, sizeof(int));
+}
+
+void checkpoint_put_ints(checkpoint *ck, const int *x, int n)
+{
+    checkpoint_put(ck, x, (size_t)n * sizeof(int));
+}
+
+void checkpoint_put_ivector(checkpoint *ck, const ivector *v)
+{
+    checkpoint_put_int(ck, v->size);
+    checkpoint_put_ints(ck, v->array, v->size);
+}
+
+void checkpoint_put_rng(checkpoint *ck, const rng_stream *r)
+{
+    // The whole struct (the pointer to the GSL generator is ignored when read back):
+    checkpoint_put(ck, r, sizeof(rng_stream));
+    if (r->type == RNG_GSL)
+    {
+        const size_t bytes = gsl_rng_size(r->gsl);
+        checkpoint_put(ck, &bytes, sizeof(size_t));
+        checkpoint_put(ck, gsl_rng_state(r->gsl), bytes);
+    }
+}
+
+void checkpoint_put_graph(checkpoint *ck, const graph_csr *g)
+{
+    checkpoint_put_int(ck, g->num_v);
+    for (int u = 0; u < g->num_v; ++u)
+    {
+        checkpoint_put_int(ck, graph_csr_outdegree(g, u));
+        checkpoint_put_ints(ck, g->target + g->offset[u], graph_csr_outdegree(g, u));
+        checkpoint_put(ck, g->weight + g->offset[u], graph_csr_outdegree(g, u) * sizeof(double));
+    }
+}
+
+void checkpoint_commit(checkpoint *ck)
+{
+    // The previous checkpoint must be on the disk before the buffers are swapped:
+    checkpoint_wait(ck);
+    char *data = ck->pending;
+    const size_t capacity = ck->pending_capacity;
+    ck->pending = ck->data;
+    ck->pending_size = ck->size;
+    ck->pending_capacity = ck->capacity;
+    if (data == NULL)
+    {
+        ck->capacity = ck->pending_capacity;
+        data = (char*)malloc(ck->capacity);
+    }
+    else
+    {
+        ck->capacity = capacity;
+    }
+    ck->data = data;
+    ck->size = 0;
+    ck->writing = pthread_create(&ck->writer, NULL, checkpoint_write, (void*)ck) == 0;
+    if (!ck->writing)
+    {
+        // No thread, write it now:
+        checkpoint_write((void*)ck);
+    }
+    ++ck->written;
+    const double pause = seconds_monotonic() - ck->begin_time;
+    if (pause > ck->max_pause)
+    {
+        ck->max_pause = pause;
+    }
+}
+
+bool checkpoint_load(checkpoint *ck, const char *filename)
+{
+    FILE *in = fopen(filename, "rb");
+    if (in == NULL)
+    {
+        return false;
+    }
+    char magic[8];
+    uint64_t size = 0;
+    uint64_t hash = 0;
+    bool ok = fread(magic, 1, 8, in) == 8 && memcmp(magic, checkpoint_magic, 8) == 0;
+    ok = ok && fread(&size, sizeof(uint64_t), 1, in) == 1;
+    if (ok)
+    {
+        if (size > ck->capacity)
+        {
+            ck->capacity = size;
+            ck->data = (char*)realloc(ck->data, ck->capacity);
+        }
+        ok = fread(ck->data, 1, size, in) == size;
+        ok = ok && fread(&hash, sizeof(uint64_t), 1, in) == 1;
+        ok = ok && hash == checkpoint_hash(ck->data, size);
+    }
+    fclose(in);
+    ck->size = ok ? size : 0;
+    ck->pos = 0;
+    ck->ok = ok;
+    return ok;
+}
+
+bool checkpoint_copy(checkpoint *ck, const checkpoint *from)
+{
+    if (from->size > ck->capacity)
+    {
+        ck->capacity = from->size;
+        ck->data = (char*)realloc(ck->data, ck->capacity);
+    }
+    memcpy(ck->data, from->data, from->size);
+    ck->size = from->size;
+    ck->pos = 0;
+    ck->ok = from->size > 0;
+    return ck->ok;
+}
+
+bool checkpoint_get(checkpoint *ck, void *x, size_t bytes)
+{
+    if (!ck->ok || ck->pos + bytes > ck->size)
+    {
+        ck->ok = false;
+        memset(x, 0, bytes);
+        return false;
+    }
+    memcpy(x, ck->data + ck->pos, bytes);
+    ck->pos += bytes;
+    return true;
+}
+
+int checkpoint_get_int(checkpoint *ck)
+{
+    int x;
+    checkpoint_get(ck, &x, sizeof(int));
+    return x;
+}
+
+bool checkpoint_get_ints(checkpoint *ck, int *x, int n)
+{
+    return checkpoint_get(ck, x, (size_t)n * sizeof(int));
+}
+
+bool checkpoint_get_ivector(checkpoint *ck, ivector *v)
+{
+    const int size = checkpoint_get_int(ck);
+    if (!ck->ok || size < 0 || ck->pos + (size_t)size * sizeof(int) > ck->size)
+    {
+        ck->ok = false;
+        return false;
+    }
+    ivector_rmvall(v);
+    ivector_add_array(v, (int*)(ck->data + ck->pos), size);
+    ck->pos += (size_t)size * sizeof(int);
+    return true;
+}
+
+bool checkpoint_get_rng(checkpoint *ck, rng_stream *r)
+{
+    gsl_rng *gsl = r->gsl;
+    const int type = r->type;
+    if (!checkpoint_get(ck, r, sizeof(rng_stream)) || r->type != type)
+    {
+        ck->ok = false;
+        r->gsl = gsl;
+        return false;
+    }
+    r->gsl = gsl;
+    if (type == RNG_GSL)
+    {
+        size_t bytes = 0;
+        checkpoint_get(ck, &bytes, sizeof(size_t));
+        if (bytes != gsl_rng_size(gsl))
+        {
+            ck->ok = false;
+            return false;
+        }
+        return checkpoint_get(ck, gsl_rng_state(gsl), bytes);
+    }
+    return true;
+}
+
+bool checkpoint_get_graph(checkpoint *ck, graph *g)
+{
+    const int vertices = checkpoint_get_int(ck);
+    if (!ck->ok || vertices <= 0)
+    {
+        ck->ok = false;
+        return false;
+    }
+    graph_init(g, vertices);
+    for (int u = 0; u < vertices && ck->ok; ++u)
+    {
+        const int edges = checkpoint_get_int(ck);
+        if (edges < 0 || ck->pos + (size_t)edges * (sizeof(int) + sizeof(double)) > ck->size)
+        {
+            ck->ok = false;
+            break;
+        }
+        // The weights are not always aligned in the buffer, so they are copied:
+        const char *adj = ck->data + ck->pos;
+        const char *w = adj + (size_t)edges * sizeof(int);
+        for (int e = 0; e < edges; ++e)
+        {
+            int v;
+            double weight;
+            memcpy(&v, adj + e * sizeof(int), sizeof(int));
+            memcpy(&weight, w + e * sizeof(double), sizeof(double));
+            graph_add_edge(g, u, v, weight);
+        }
+        ck->pos += (size_t)edges * (sizeof(int) + sizeof(double));
+    }
+    return ck->ok;
+}
+
+void checkpoint_print(const checkpoint *ck, FILE *out)
+{
+    fprintf(out, "  <checkpoints>\n");
+    fprintf(out, "    <written>%d</written>\n", ck->written);
+    fprintf(out, "    <bytes>%lu</bytes>\n", (unsigned long)ck->pending_size);
+    fprintf(out, "    <max_pause_ms>%.3f</max_pause_ms>\n", ck->max_pause * 1000.0);
+    fprintf(out, "    <write_seconds>%.4f</write_seconds>\n", ck->write_seconds);
+    fprintf(out, "    <failed>%s</failed>\n", ck->failed ? "true" : "false");
+    fprintf(out, "  </checkpoints>\n");
+}
+
+void checkpoint_free(checkpoint *ck)
+{
+    checkpoint_wait(ck);
+    free(ck->data);
+    free(ck->pending);
+    free(ck->filename);
+}
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions
+
+void *checkpoint_write(void *arg)
+{
+    checkpoint *ck = (checkpoint*)arg;
+    const double start = seconds_monotonic();
+    const size_t length = strlen(ck->filename);
+    char *tmp = (char*)malloc(length + 5);
+    sprintf(tmp, "%s.tmp", ck->filename);
+    FILE *out = fopen(tmp, "wb");
+    bool ok = out != NULL;
+    if (ok)
+    {
+        const uint64_t size = ck->pending_size;
+        const uint64_t hash = checkpoint_hash(ck->pending, ck->pending_size);
+        ok = fwrite(checkpoint_magic, 1, 8, out) == 8;
+        ok = ok && fwrite(&size, sizeof(uint64_t), 1, out) == 1;
+        ok = ok && fwrite(ck->pending, 1, ck->pending_size, out) == ck->pending_size;
+        ok = ok && fwrite(&hash, sizeof(uint64_t), 1, out) == 1;
+        ok = ok && fflush(out) == 0 && fsync(fileno(out)) == 0;
+        ok = fclose(out) == 0 && ok;
+    }
+    // The rename replaces the previous checkpoint in one step:
+    ok = ok && rename(tmp, ck->filename) == 0;
+    if (!ok)
+    {
+        ck->failed = true;
+    }
+    free(tmp);
+    ck->write_seconds += seconds_monotonic() - start;
+    return NULL;
+}
+
+void checkpoint_wait(checkpoint *ck)
+{
+    if (ck->writing)
+    {
+        pthread_join(ck->writer, NULL);
+        ck->writing = false;
+    }
+}
+
+uint64_t checkpoint_hash(const char *data, size_t bytes)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < bytes; ++i)
+    {
+        h ^= (unsigned char)data[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
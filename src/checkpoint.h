@@ -0,0 +1,135 @@
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "ivector.h"
+#include "rng.h"
+#include "graph.h"
+
+/** Version of the format, increased when the content changes. */
+#define CHECKPOINT_VERSION     4
+
+/**
+ * A binary checkpoint of a simulation: a buffer of raw values written and
+ * read back in the same order (the machine must be the same, the format is
+ * not portable).
+ *
+ * checkpoint_begin empties the buffer, the checkpoint_put functions append
+ * to it, and checkpoint_commit hands it to a thread that writes it to
+ * 'filename'.tmp, flushes it to the disk and renames it to 'filename', so
+ * the file is always either the previous checkpoint or the new one. The
+ * simulation only waits for the copy of its state in memory, and for the
+ * previous write if it is not done when the next checkpoint begins.
+ *
+ * checkpoint_load reads a file (checking its size and checksum) and the
+ * checkpoint_get functions read the values back in order.
+ */
+typedef struct
+{
+    char *data; /** The values. */
+
+    size_t size; /** Number of bytes in 'data'. */
+
+    size_t capacity; /** Capacity of 'data'. */
+
+    size_t pos; /** Next byte read by the checkpoint_get functions. */
+
+    bool ok; /** False once a read went past the end of the data. */
+
+    char *filename; /** Where the checkpoints are written. */
+
+    char *pending; /** Buffer being written by the thread. */
+
+    size_t pending_size; /** Number of bytes in 'pending'. */
+
+    size_t pending_capacity; /** Capacity of 'pending'. */
+
+    pthread_t writer; /** The thread writing 'pending'. */
+
+    bool writing; /** True if the thread is running. */
+
+    bool failed; /** True if a write failed. */
+
+    int written; /** Number of checkpoints committed. */
+
+    double begin_time; /** When the current checkpoint began. */
+
+    double max_pause; /** Longest time the simulation waited for a checkpoint (seconds). */
+
+    double write_seconds; /** Time spent by the thread writing the files. */
+}
+checkpoint;
+
+/** Initialize an empty checkpoint written to 'filename' (NULL to only load). */
+void checkpoint_init(checkpoint *ck, const char *filename);
+
+/** Wait for the previous write and empty the buffer. */
+void checkpoint_begin(checkpoint *ck);
+
+/** Append 'bytes' bytes. */
+void checkpoint_put(checkpoint *ck, const void *x, size_t bytes);
+
+/** Append an int. */
+void checkpoint_put_int(checkpoint *ck, int x);
+
+/** Append an array of 'n' ints. */
+void checkpoint_put_ints(checkpoint *ck, const int *x, int n);
+
+/** Append a vector (its size then its elements). */
+void checkpoint_put_ivector(checkpoint *ck, const ivector *v);
+
+/** Append the state of a random stream. */
+void checkpoint_put_rng(checkpoint *ck, const rng_stream *r);
+
+/** Append a graph (vertices, then the edges and weights of each vertex). */
+void checkpoint_put_graph(checkpoint *ck, const graph_csr *g);
+
+/** Start writing the checkpoint in the background. */
+void checkpoint_commit(checkpoint *ck);
+
+/** Read a checkpoint written by checkpoint_commit, return false if it can't be read or is corrupted. */
+bool checkpoint_load(checkpoint *ck, const char *filename);
+
+/** Read back the data of another checkpoint (e.g. one kept in memory), return false if it is empty. */
+bool checkpoint_copy(checkpoint *ck, const checkpoint *from);
+
+/** Read 'bytes' bytes, return false past the end of the data. */
+bool checkpoint_get(checkpoint *ck, void *x, size_t bytes);
+
+/** Read an int (0 past the end of the data). */
+int checkpoint_get_int(checkpoint *ck);
+
+/** Read an array of 'n' ints. */
+bool checkpoint_get_ints(checkpoint *ck, int *x, int n);
+
+/** Read a vector into an initialized vector (its content is replaced). */
+bool checkpoint_get_ivector(checkpoint *ck, ivector *v);
+
+/** Read the state of a random stream into a stream of the same backend. */
+bool checkpoint_get_rng(checkpoint *ck, rng_stream *r);
+
+/** Read a graph (written from its frozen form) into an uninitialized graph. */
+bool checkpoint_get_graph(checkpoint *ck, graph *g);
+
+/** Print the number of checkpoints, their size, and the time spent. */
+void checkpoint_print(const checkpoint *ck, FILE *out);
+
+/** Wait for the last write and free the memory. */
+void checkpoint_free(checkpoint *ck);
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions. You shouldn't need those.
+
+/** Main function of the writer thread ('arg' points to the checkpoint). */
+void *checkpoint_write(void *arg);
+
+/** Wait for the writer thread, if any. */
+void checkpoint_wait(checkpoint *ck);
+
+/** FNV-1a hash of 'bytes' bytes. */
+uint64_t checkpoint_hash(const char *data, size_t bytes);
+
+#endif
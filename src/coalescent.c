@@ -0,0 +1,342 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "common.h"
+#include "ivector.h"
+#include "rng.h"
+#include "migration.h"
+#include "species.h"
+#include "specieslist.h"
+#include "coalescent.h"
+
+void coalescent_init(coalescent *co, int communities, int j_per_c, int k_gen, double mu)
+{
+    co->communities = communities;
+    co->j_per_c = j_per_c;
+    co->k_gen = k_gen;
+    co->mu = mu;
+    co->n_nodes = 0;
+    co->capacity = 2 * communities * j_per_c;
+    co->nodes = (coalescent_node*)malloc(co->capacity * sizeof(coalescent_node));
+    for (int c = 0; c < communities; ++c)
+    {
+        for (int i = 0; i < j_per_c; ++i)
+        {
+            coalescent_add_node(co, c);
+        }
+    }
+    co->events = 0;
+    co->coalescences = 0;
+    co->roots = communities * j_per_c;
+}
+
+void coalescent_run(coalescent *co, const migration_sampler *ms, rng_stream *rng)
+{
+    const int n = co->communities * co->j_per_c;
+    const int j_per_c = co->j_per_c;
+    const long steps = (long)co->k_gen * 1000 * j_per_c;
+
+    // The lineages still followed: their current branch, community, and
+    // position in the list of lineages of the community.
+    int *branch = (int*)malloc(n * sizeof(int));
+    int *community = (int*)malloc(n * sizeof(int));
+    int *where = (int*)malloc(n * sizeof(int));
+    ivector *members = (ivector*)malloc(co->communities * sizeof(ivector));
+    for (int c = 0; c < co->communities; ++c)
+    {
+        ivector_init1(&members[c], j_per_c);
+    }
+    // Min-heap of the next time step (backward) each lineage is hit:
+    long *time = (long*)malloc(n * sizeof(long));
+    int *id = (int*)malloc(n * sizeof(int));
+    int size = 0;
+    for (int a = 0; a < n; ++a)
+    {
+        branch[a] = a;
+        community[a] = a / j_per_c;
+        where[a] = members[community[a]].size;
+        ivector_add(&members[community[a]], a);
+        time[size] = coalescent_skip(co, rng);
+        id[size] = a;
+        coalescent_sift_up(time, id, size++);
+    }
+
+    while (size > 0 && time[0] < steps)
+    {
+        const long now = time[0];
+        const int a = id[0];
+        const int c = community[a];
+        const int date = co->k_gen * 1000 - 1 - (int)(now / j_per_c);
+        ++co->events;
+
+        // The parent, picked like in the forward model:
+        const int v1 = migration_sampler_draw(ms, c, rng_stream_uniform(rng));
+        int type = COALESCENT_MIGRATION;
+        if (v1 == c)
+        {
+            type = rng_stream_uniform(rng) < co->mu ? COALESCENT_MUTATION : COALESCENT_LOCAL;
+        }
+        // The parent is one of the lineages of 'v1' with probability (lineages / j_per_c):
+        const int others = members[v1].size - (v1 == c ? 1 : 0);
+        int position = rng_stream_bounded(rng, j_per_c);
+        if (position < others)
+        {
+            if (v1 == c && position >= where[a])
+            {
+                ++position;
+            }
+            const int partner = members[v1].array[position];
+            const int top = coalescent_add_node(co, v1);
+            co->nodes[branch[a]].parent = top;
+            co->nodes[branch[a]].date = date;
+            co->nodes[branch[a]].type = type;
+            co->nodes[branch[partner]].parent = top;
+            co->nodes[branch[partner]].date = date;
+            co->nodes[branch[partner]].type = COALESCENT_NONE;
+            branch[partner] = top;
+            ++co->coalescences;
+
+            // Remove 'a' from its community:
+            const int last = members[c].array[members[c].size - 1];
+            members[c].array[where[a]] = last;
+            where[last] = where[a];
+            ivector_sub1(&members[c]);
+
+            // ...and from the heap:
+            --size;
+            time[0] = time[size];
+            id[0] = id[size];
+            coalescent_sift_down(time, id, size, 0);
+            continue;
+        }
+        if (type != COALESCENT_LOCAL)
+        {
+            const int top = coalescent_add_node(co, v1);
+            co->nodes[branch[a]].parent = top;
+            co->nodes[branch[a]].date = date;
+            co->nodes[branch[a]].type = type;
+            branch[a] = top;
+            if (v1 != c)
+            {
+                const int last = members[c].array[members[c].size - 1];
+                members[c].array[where[a]] = last;
+                where[last] = where[a];
+                ivector_sub1(&members[c]);
+                community[a] = v1;
+                where[a] = members[v1].size;
+                ivector_add(&members[v1], a);
+            }
+        }
+        time[0] = now + coalescent_skip(co, rng);
+        coalescent_sift_down(time, id, size, 0);
+    }
+    co->roots = size;
+
+    free(branch);
+    free(community);
+    free(where);
+    for (int c = 0; c < co->communities; ++c)
+    {
+        ivector_free(&members[c]);
+    }
+    free(members);
+    free(time);
+    free(id);
+}
+
+species_list *coalescent_to_species_list(const coalescent *co, int init_species, rng_stream *rng, int *speciation_events, int *speciation_per_c)
+{
+    const int n = co->communities * co->j_per_c;
+    const int init_pop_size = co->j_per_c / init_species;
+    const int remainder = co->j_per_c - (init_species * init_pop_size);
+    int *sp = (int*)malloc(co->n_nodes * sizeof(int));
+    int *genotype = (int*)malloc(co->n_nodes * sizeof(int));
+    // The roots are distinct individuals of the initial metacommunity: the
+    // positions of each community are drawn without replacement (a partial
+    // Fisher-Yates shuffle, started when the community gets its first root):
+    int *positions = (int*)malloc(n * sizeof(int));
+    int *drawn = (int*)calloc(co->communities, sizeof(int));
+    // Date and community of the new species:
+    ivector birth;
+    ivector origin;
+    ivector_init0(&birth);
+    ivector_init0(&origin);
+
+    // The parents come after their children:
+    for (int i = co->n_nodes - 1; i >= 0; --i)
+    {
+        const coalescent_node *node = &co->nodes[i];
+        if (node->parent == -1)
+        {
+            // An individual of the initial metacommunity:
+            int *left = positions + node->community * co->j_per_c;
+            int *k = &drawn[node->community];
+            if (*k % co->j_per_c == 0)
+            {
+                // The first root of the community (or one more root than individuals, the
+                // approximation of the process allowing it, and the draws start over):
+                *k = 0;
+                for (int j = 0; j < co->j_per_c; ++j)
+                {
+                    left[j] = j;
+                }
+            }
+            const int pick = *k + rng_stream_bounded(rng, co->j_per_c - *k);
+            const int position = left[pick];
+            left[pick] = left[*k];
+            left[(*k)++] = position;
+            if (position < remainder * (init_pop_size + 1))
+            {
+                sp[i] = position / (init_pop_size + 1);
+            }
+            else
+            {
+                sp[i] = remainder + (position - remainder * (init_pop_size + 1)) / init_pop_size;
+            }
+            genotype[i] = 0;
+            continue;
+        }
+        sp[i] = sp[node->parent];
+        genotype[i] = genotype[node->parent];
+        if (node->type == COALESCENT_MIGRATION)
+        {
+            genotype[i] = 0;
+        }
+        else if (node->type == COALESCENT_MUTATION && ++genotype[i] == 2)
+        {
+            sp[i] = init_species + birth.size;
+            genotype[i] = 0;
+            ivector_add(&birth, node->date);
+            ivector_add(&origin, node->community);
+        }
+    }
+
+    // Count the individuals of each species:
+    const int n_species = init_species + birth.size;
+    species **all = (species**)calloc(n_species, sizeof(species*));
+    for (int i = 0; i < n; ++i)
+    {
+        const int c = co->nodes[i].community;
+        if (all[sp[i]] == NULL)
+        {
+            all[sp[i]] = species_init(co->communities, sp[i] < init_species ? 0 : birth.array[sp[i] - init_species], 3);
+        }
+        all[sp[i]]->n[c]++;
+        all[sp[i]]->total++;
+        all[sp[i]]->genotypes[genotype[i]][c]++;
+    }
+    species_list *list = species_list_init();
+    for (int i = 0; i < n_species; ++i)
+    {
+        if (all[i] == NULL)
+        {
+            continue;
+        }
+        species_list_add(list, all[i]);
+        if (i >= init_species)
+        {
+            speciation_events[birth.array[i - init_species] / 1000]++;
+            speciation_per_c[origin.array[i - init_species]]++;
+        }
+    }
+    free(all);
+    free(sp);
+    free(genotype);
+    free(positions);
+    free(drawn);
+    ivector_free(&birth);
+    ivector_free(&origin);
+    return list;
+}
+
+void coalescent_print_report(const coalescent *co, FILE *out)
+{
+    fprintf(out, "  <coalescent>\n");
+    fprintf(out, "    <events>%ld</events>\n", co->events);
+    fprintf(out, "    <coalescences>%d</coalescences>\n", co->coalescences);
+    fprintf(out, "    <branches>%d</branches>\n", co->n_nodes);
+    fprintf(out, "    <roots>%d</roots>\n", co->roots);
+    fprintf(out, "  </coalescent>\n");
+}
+
+void coalescent_free(coalescent *co)
+{
+    free(co->nodes);
+}
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions
+
+int coalescent_add_node(coalescent *co, int community)
+{
+    if (co->n_nodes == co->capacity)
+    {
+        co->capacity *= VECTOR_GROW_RATE;
+        co->nodes = (coalescent_node*)realloc(co->nodes, co->capacity * sizeof(coalescent_node));
+    }
+    coalescent_node *node = &co->nodes[co->n_nodes];
+    node->parent = -1;
+    node->date = 0;
+    node->community = community;
+    node->type = COALESCENT_NONE;
+    return co->n_nodes++;
+}
+
+ORIGIN_INLINE long coalescent_skip(coalescent *co, rng_stream *rng)
+{
+    if (co->j_per_c == 1)
+    {
+        return 1;
+    }
+    // Geometric with p = 1 / j_per_c, at least 1:
+    const double u = 1.0 - rng_stream_uniform(rng);
+    return 1 + (long)(log(u) / log(1.0 - 1.0 / co->j_per_c));
+}
+
+void coalescent_sift_down(long *time, int *id, int size, int i)
+{
+    while (true)
+    {
+        int smallest = i;
+        const int l = 2 * i + 1;
+        const int r = l + 1;
+        if (l < size && time[l] < time[smallest])
+        {
+            smallest = l;
+        }
+        if (r < size && time[r] < time[smallest])
+        {
+            smallest = r;
+        }
+        if (smallest == i)
+        {
+            return;
+        }
+        const long t = time[i];
+        const int a = id[i];
+        time[i] = time[smallest];
+        id[i] = id[smallest];
+        time[smallest] = t;
+        id[smallest] = a;
+        i = smallest;
+    }
+}
+
+void coalescent_sift_up(long *time, int *id, int i)
+{
+    while (i > 0)
+    {
+        const int parent = (i - 1) / 2;
+        if (time[parent] <= time[i])
+        {
+            return;
+        }
+        const long t = time[i];
+        const int a = id[i];
+        time[i] = time[parent];
+        id[i] = id[parent];
+        time[parent] = t;
+        id[parent] = a;
+        i = parent;
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef COALESCENT_H_
+#define COALESCENT_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "rng.h"
+#include "migration.h"
+#include "specieslist.h"
+
+/** Events closing a branch of the genealogy (the birth of its lineage). */
+#define COALESCENT_NONE         0
+#define COALESCENT_LOCAL        1
+#define COALESCENT_MUTATION     2
+#define COALESCENT_MIGRATION    3
+
+/**
+ * A branch of the genealogy: a lineage between two events that matter
+ * (mutation, migration or coalescence). The event at the top of the branch
+ * is the birth of the lineage from the individual of the 'parent' branch.
+ */
+typedef struct
+{
+    int parent; /** Branch of the parent (-1 for the roots). */
+
+    int date; /** Generation of the event at the top of the branch. */
+
+    int community; /** Community of the lineage. */
+
+    int type; /** Event at the top of the branch (COALESCENT_NONE for a coalescence). */
+}
+coalescent_node;
+
+/**
+ * Backward-time spatial coalescent for the neutral model. The lineages of
+ * all the individuals of the final metacommunity are followed back in time
+ * over the same graph and migration probabilities as the forward model,
+ * for the same number of generations. A lineage in a community of 'j_per_c'
+ * individuals is hit by a replacement with probability 1/j_per_c per time
+ * step, so only the steps that hit a lineage are simulated (geometric
+ * skips). When hit, the lineage moves to its parent, picked like in the
+ * forward model, and merges with the lineage already there, if any.
+ *
+ * The speciation rule is applied forward on the genealogy: the roots
+ * belong to the initial species with genotype aa, a local birth mutates
+ * with probability 'mu' (aa to Ab, Ab to AB), migrants are aa, and a
+ * lineage reaching AB founds a new species (and goes back to aa). This is
+ * the lineage-level version of the BDM rule of the forward model, which
+ * needs the whole local population to be AB.
+ */
+typedef struct
+{
+    int communities; /** Number of communities. */
+
+    int j_per_c; /** Number of individuals per community. */
+
+    int k_gen; /** Number of generations (in thousands). */
+
+    double mu; /** Mutation rate. */
+
+    coalescent_node *nodes; /** The branches (the first communities * j_per_c are the individuals). */
+
+    int n_nodes; /** Number of branches. */
+
+    int capacity; /** Capacity of 'nodes'. */
+
+    long events; /** Number of replacements that hit a lineage. */
+
+    int coalescences; /** Number of coalescences. */
+
+    int roots; /** Number of lineages left at the start of the simulation. */
+}
+coalescent;
+
+/** Initialize the struct, one lineage per individual. */
+void coalescent_init(coalescent *co, int communities, int j_per_c, int k_gen, double mu);
+
+/** Follow the lineages back in time for 'k_gen' thousands of generations. */
+void coalescent_run(coalescent *co, const migration_sampler *ms, rng_stream *rng);
+
+/**
+ * Apply the speciation rule forward on the genealogy and return the extant
+ * species. The roots are distinct individuals of the initial metacommunity
+ * (drawn without replacement in each community), so they are assigned to
+ * the 'init_species' initial species in its proportions. The foundations
+ * of extant species are added to 'speciation_events' (per thousand
+ * generations) and 'speciation_per_c'.
+ */
+species_list *coalescent_to_species_list(const coalescent *co, int init_species, rng_stream *rng, int *speciation_events, int *speciation_per_c);
+
+/** Print the number of events, coalescences and roots. */
+void coalescent_print_report(const coalescent *co, FILE *out);
+
+/** Free the memory. */
+void coalescent_free(coalescent *co);
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions. You shouldn't need those.
+
+/** Add a branch and return its index. */
+int coalescent_add_node(coalescent *co, int community);
+
+/** Number of time steps until the next replacement hits a lineage. */
+long coalescent_skip(coalescent *co, rng_stream *rng);
+
+/** Restore the heap property from position 'i' downward. */
+void coalescent_sift_down(long *time, int *id, int size, int i);
+
+/** Restore the heap property from position 'i' upward. */
+void coalescent_sift_up(long *time, int *id, int i);
+
+#endif
@@ -30,11 +30,23 @@
 #define GRAPH_INIT_CAPACITY 16
 #endif
 
+// How much larger than the radius are the cells used to build geometric graphs
+#ifndef GRAPH_CELL_MARGIN
+#define GRAPH_CELL_MARGIN 1.000001
+#endif
+
 // The character to use as separator for int_with_space and long_with_space
 #ifndef UTILS_SEPARATOR 
 #define UTILS_SEPARATOR ' '
 #endif
 
+// Force inlining, used to specialise functions on constant arguments
+#ifdef __GNUC__
+#define ORIGIN_FORCE_INLINE static inline __attribute__((always_inline))
+#else
+#define ORIGIN_FORCE_INLINE static inline
+#endif
+
 #ifndef NULL
 #define NULL 0
 #endif
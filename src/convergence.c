@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include "convergence.h"
+
+void convergence_init(convergence *cv, int window, double tolerance, int k_first)
+{
+    cv->window = window >= 2 ? window : 0;
+    cv->tolerance = tolerance;
+    cv->k_first = k_first;
+    cv->k_stop = 0;
+    for (int i = 0; i < CONVERGENCE_SERIES; ++i)
+    {
+        cv->change[i] = 0.0;
+    }
+}
+
+bool convergence_check(convergence *cv, const int *total_species, const int *speciation_events, const int *extinction_events, int k)
+{
+    if (cv->window == 0 || cv->k_stop > 0 || k + 1 - cv->k_first < cv->window)
+    {
+        return false;
+    }
+    const int first = k + 1 - cv->window;
+    cv->change[0] = convergence_change(total_species + first, cv->window);
+    cv->change[1] = convergence_change(speciation_events + first, cv->window);
+    cv->change[2] = convergence_change(extinction_events + first, cv->window);
+    for (int i = 0; i < CONVERGENCE_SERIES; ++i)
+    {
+        if (cv->change[i] > cv->tolerance)
+        {
+            return false;
+        }
+    }
+    cv->k_stop = k + 1;
+    return true;
+}
+
+void convergence_print(const convergence *cv, FILE *out)
+{
+    fprintf(out, "  <convergence>\n");
+    fprintf(out, "    <window>%d</window>\n", cv->window);
+    fprintf(out, "    <tolerance>%.4f</tolerance>\n", cv->tolerance);
+    fprintf(out, "    <stopped>%s</stopped>\n", cv->k_stop > 0 ? "true" : "false");
+    if (cv->k_stop > 0)
+    {
+        fprintf(out, "    <stopped_at_k>%d</stopped_at_k>\n", cv->k_stop);
+        fprintf(out, "    <stopped_at_generation>%d</stopped_at_generation>\n", cv->k_stop * 1000);
+    }
+    fprintf(out, "    <richness_change>%.4f</richness_change>\n", cv->change[0]);
+    fprintf(out, "    <speciation_change>%.4f</speciation_change>\n", cv->change[1]);
+    fprintf(out, "    <extinction_change>%.4f</extinction_change>\n", cv->change[2]);
+    fprintf(out, "  </convergence>\n");
+}
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions
+
+double convergence_change(const int *series, int n)
+{
+    // With an odd window, the middle value is in neither half:
+    const int half = n / 2;
+    double first = 0.0;
+    double second = 0.0;
+    for (int i = 0; i < half; ++i)
+    {
+        first += series[i];
+        second += series[n - half + i];
+    }
+    first /= half;
+    second /= half;
+    const double mean = 0.5 * (first + second);
+    return fabs(second - first) / (mean > 1.0 ? mean : 1.0);
+}
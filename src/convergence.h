@@ -0,0 +1,55 @@
+#ifndef CONVERGENCE_H_
+#define CONVERGENCE_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/** Number of series checked (richness, speciation and extinction events). */
+#define CONVERGENCE_SERIES     3
+
+/**
+ * Online detection of the stationarity of a simulation, checked at the end
+ * of every group of 1000 generations on the series of the number of
+ * species, speciation events and extinctions.
+ *
+ * The last 'window' groups are split in two halves, and a series is
+ * stationary if the means of the halves differ by at most 'tolerance'
+ * times their mean (the means under 1 count as 1, so the
+ * series of a few events are not too sensitive). The simulation can stop
+ * once the three series are stationary, which can't happen before
+ * 'window' groups are done by the simulation itself: the groups a replicate
+ * gets from a shared burn-in don't count. Each check is \f$O(window)\f$.
+ */
+typedef struct
+{
+    int window; /** Groups of 1000 generations the series must be stationary over (0 = never stop). */
+
+    double tolerance; /** Largest relative difference accepted between the halves of the window. */
+
+    int k_first; /** First group simulated by the replicate (the end of the burn-in it branched from, or 0). */
+
+    int k_stop; /** Number of groups done when the simulation stopped (0 while it runs). */
+
+    double change[CONVERGENCE_SERIES]; /** Relative difference of each series at the last check. */
+}
+convergence;
+
+/** Initialize the detector ('window' < 2 means never stop) for a replicate starting at the group 'k_first'. */
+void convergence_init(convergence *cv, int window, double tolerance, int k_first);
+
+/**
+ * Check the series after the group 'k' is done (the series hold at least
+ * k + 1 values) and return true if the simulation can stop.
+ */
+bool convergence_check(convergence *cv, const int *total_species, const int *speciation_events, const int *extinction_events, int k);
+
+/** Print the settings, the generation where the simulation stopped and the last differences. */
+void convergence_print(const convergence *cv, FILE *out);
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions. You shouldn't need those.
+
+/** Relative difference between the means of the two halves of 'n' values. */
+double convergence_change(const int *series, int n);
+
+#endif
@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include "ensemble.h"
+
+// The quantiles printed:
+static const double ensemble_p[ENSEMBLE_QUANTILES] = { 0.05, 0.25, 0.5, 0.75, 0.95 };
+static const char *ensemble_q[ENSEMBLE_QUANTILES] = { "q05", "q25", "median", "q75", "q95" };
+
+void ensemble_init(ensemble *e, int replicates)
+{
+    e->replicates = replicates;
+    for (int s = 0; s < ENSEMBLE_STATS; ++s)
+    {
+        e->rows[s] = (double**)calloc(replicates, sizeof(double*));
+        e->length[s] = (int*)calloc(replicates, sizeof(int));
+    }
+}
+
+void ensemble_fold_ints(ensemble *e, int stat, int replicate, const int *x, int n)
+{
+    double *row = (double*)malloc((n > 0 ? n : 1) * sizeof(double));
+    for (int i = 0; i < n; ++i)
+    {
+        row[i] = (double)x[i];
+    }
+    e->rows[stat][replicate] = row;
+    e->length[stat][replicate] = n;
+}
+
+void ensemble_fold_reals(ensemble *e, int stat, int replicate, const double *x, int n)
+{
+    double *row = (double*)malloc((n > 0 ? n : 1) * sizeof(double));
+    for (int i = 0; i < n; ++i)
+    {
+        row[i] = x[i];
+    }
+    e->rows[stat][replicate] = row;
+    e->length[stat][replicate] = n;
+}
+
+int ensemble_folded(const ensemble *e)
+{
+    int folded = 0;
+    for (int r = 0; r < e->replicates; ++r)
+    {
+        folded += e->rows[ENSEMBLE_RICHNESS][r] != NULL ? 1 : 0;
+    }
+    return folded;
+}
+
+void ensemble_print(const ensemble *e, FILE *out)
+{
+    fprintf(out, "<?xml version=\"1.0\"?>\n");
+    fprintf(out, "<ensemble>\n");
+    fprintf(out, "  <replicates>%d</replicates>\n", ensemble_folded(e));
+    for (int s = 0; s < ENSEMBLE_STATS; ++s)
+    {
+        ensemble_print_stat(e, s, out);
+    }
+    fprintf(out, "</ensemble>\n");
+}
+
+void ensemble_free(ensemble *e)
+{
+    for (int s = 0; s < ENSEMBLE_STATS; ++s)
+    {
+        for (int r = 0; r < e->replicates; ++r)
+        {
+            free(e->rows[s][r]);
+        }
+        free(e->rows[s]);
+        free(e->length[s]);
+    }
+}
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions
+
+const char *ensemble_name(int stat)
+{
+    switch (stat)
+    {
+    case ENSEMBLE_RICHNESS:
+        return "extant_species_per_k_gen";
+    case ENSEMBLE_SPECIATION:
+        return "speciation_per_k_gen";
+    case ENSEMBLE_EXTINCTION:
+        return "extinctions_per_k_gen";
+    case ENSEMBLE_RANKS:
+        return "rank_abundance";
+    default:
+        return "octaves";
+    }
+}
+
+void ensemble_print_stat(const ensemble *e, int stat, FILE *out)
+{
+    // The series skip the missing values, the others count them as 0:
+    const bool pad = stat == ENSEMBLE_RANKS || stat == ENSEMBLE_OCTAVES;
+    int width = 0;
+    for (int r = 0; r < e->replicates; ++r)
+    {
+        if (e->length[stat][r] > width)
+        {
+            width = e->length[stat][r];
+        }
+    }
+    int *n = (int*)malloc((width > 0 ? width : 1) * sizeof(int));
+    double *mean = (double*)malloc((width > 0 ? width : 1) * sizeof(double));
+    double *var = (double*)malloc((width > 0 ? width : 1) * sizeof(double));
+    double *q = (double*)malloc((width > 0 ? width : 1) * ENSEMBLE_QUANTILES * sizeof(double));
+    double *values = (double*)malloc((e->replicates > 0 ? e->replicates : 1) * sizeof(double));
+    for (int i = 0; i < width; ++i)
+    {
+        // The values of the element 'i', in the order of the replicates:
+        n[i] = 0;
+        for (int r = 0; r < e->replicates; ++r)
+        {
+            if (e->rows[stat][r] == NULL)
+            {
+                continue;
+            }
+            if (i < e->length[stat][r])
+            {
+                values[n[i]++] = e->rows[stat][r][i];
+            }
+            else if (pad)
+            {
+                values[n[i]++] = 0.0;
+            }
+        }
+        double sum = 0.0;
+        for (int j = 0; j < n[i]; ++j)
+        {
+            sum += values[j];
+        }
+        mean[i] = n[i] > 0 ? sum / n[i] : 0.0;
+        double ss = 0.0;
+        for (int j = 0; j < n[i]; ++j)
+        {
+            ss += (values[j] - mean[i]) * (values[j] - mean[i]);
+        }
+        var[i] = n[i] > 1 ? ss / (n[i] - 1) : 0.0;
+        qsort(values, n[i], sizeof(double), ensemble_compare);
+        for (int k = 0; k < ENSEMBLE_QUANTILES; ++k)
+        {
+            q[k * width + i] = ensemble_quantile(values, n[i], ensemble_p[k]);
+        }
+    }
+
+    fprintf(out, "  <stat>\n");
+    fprintf(out, "    <name>%s</name>\n", ensemble_name(stat));
+    fprintf(out, "    <n>");
+    for (int i = 0; i < width; ++i)
+    {
+        fprintf(out, i < width - 1 ? "%d " : "%d", n[i]);
+    }
+    fprintf(out, "</n>\n");
+    ensemble_print_row("mean", mean, width, out);
+    ensemble_print_row("variance", var, width, out);
+    for (int k = 0; k < ENSEMBLE_QUANTILES; ++k)
+    {
+        ensemble_print_row(ensemble_q[k], q + k * width, width, out);
+    }
+    fprintf(out, "  </stat>\n");
+    free(n);
+    free(mean);
+    free(var);
+    free(q);
+    free(values);
+}
+
+void ensemble_print_row(const char *tag, const double *x, int n, FILE *out)
+{
+    fprintf(out, "    <%s>", tag);
+    for (int i = 0; i < n; ++i)
+    {
+        fprintf(out, i < n - 1 ? "%.4f " : "%.4f", x[i]);
+    }
+    fprintf(out, "</%s>\n", tag);
+}
+
+double ensemble_quantile(const double *sorted, int n, double p)
+{
+    if (n == 0)
+    {
+        return 0.0;
+    }
+    const double h = (n - 1) * p;
+    const int lo = (int)floor(h);
+    if (lo + 1 >= n)
+    {
+        return sorted[n - 1];
+    }
+    return sorted[lo] + (h - lo) * (sorted[lo + 1] - sorted[lo]);
+}
+
+int ensemble_compare(const void *a, const void *b)
+{
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
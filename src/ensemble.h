@@ -0,0 +1,77 @@
+#ifndef ENSEMBLE_H_
+#define ENSEMBLE_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/** The statistics of an ensemble. */
+#define ENSEMBLE_RICHNESS      0
+#define ENSEMBLE_SPECIATION    1
+#define ENSEMBLE_EXTINCTION    2
+#define ENSEMBLE_RANKS         3
+#define ENSEMBLE_OCTAVES       4
+#define ENSEMBLE_STATS         5
+
+/** Number of quantiles printed. */
+#define ENSEMBLE_QUANTILES     5
+
+/**
+ * Summary of the replicates of a parameter point: for the series per 1000
+ * generations (species, speciation events and extinctions), the abundances
+ * of the species by rank (the most abundant first) and the octaves, the
+ * mean, variance and quantiles of each element over the replicates.
+ *
+ * Each replicate fills its own row of every statistic, so the threads
+ * running them never share anything until ensemble_print reduces the rows
+ * (the result doesn't depend on the order the replicates end). The rows of
+ * the series can be shorter (a replicate stopped by -converge), the missing
+ * values are not counted. The rows of the ranks and octaves are padded with
+ * zeros to the longest one.
+ */
+typedef struct
+{
+    int replicates; /** Number of replicates. */
+
+    double **rows[ENSEMBLE_STATS]; /** The values of each replicate (NULL until folded). */
+
+    int *length[ENSEMBLE_STATS]; /** Number of values of each row. */
+}
+ensemble;
+
+/** Initialize an ensemble of 'replicates' replicates. */
+void ensemble_init(ensemble *e, int replicates);
+
+/** Store the 'n' values of a statistic of a replicate. */
+void ensemble_fold_ints(ensemble *e, int stat, int replicate, const int *x, int n);
+
+/** Store the 'n' values of a statistic of a replicate. */
+void ensemble_fold_reals(ensemble *e, int stat, int replicate, const double *x, int n);
+
+/** Number of replicates folded. */
+int ensemble_folded(const ensemble *e);
+
+/** Print the summary of every statistic. */
+void ensemble_print(const ensemble *e, FILE *out);
+
+/** Free the memory. */
+void ensemble_free(ensemble *e);
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions. You shouldn't need those.
+
+/** Name of a statistic (for the output). */
+const char *ensemble_name(int stat);
+
+/** Print the number of values, mean, variance and quantiles of each element of a statistic. */
+void ensemble_print_stat(const ensemble *e, int stat, FILE *out);
+
+/** Print the 'n' values of 'x' as the element 'tag'. */
+void ensemble_print_row(const char *tag, const double *x, int n, FILE *out);
+
+/** Quantile 'p' of 'n' sorted values (linear interpolation between the closest ranks). */
+double ensemble_quantile(const double *sorted, int n, double p);
+
+/** Order of doubles for qsort. */
+int ensemble_compare(const void *a, const void *b);
+
+#endif
@@ -0,0 +1,88 @@
+#include <stdlib.h>
+#include <string.h>
+#include "common.h"
+#include "fenwick.h"
+
+void fenwick_init(fenwick *f, int communities, int capacity)
+{
+    f->communities = communities;
+    f->capacity = 0;
+    f->tree = NULL;
+    fenwick_reset(f, capacity);
+}
+
+ORIGIN_INLINE void fenwick_add(fenwick *f, int c, int slot, int delta)
+{
+    int *tree = f->tree + (size_t)c * f->capacity;
+    const int capacity = f->capacity;
+    for (int i = slot + 1; i <= capacity; i += i & -i)
+    {
+        tree[i - 1] += delta;
+    }
+}
+
+ORIGIN_INLINE int fenwick_find(const fenwick *f, int c, int position)
+{
+    const int *tree = f->tree + (size_t)c * f->capacity;
+    int slot = 0;
+    // Descend from the largest power of 2, skipping whole blocks of slots:
+    for (int step = f->capacity; step > 0; step >>= 1)
+    {
+        const int next = slot + step;
+        if (next <= f->capacity && tree[next - 1] <= position)
+        {
+            slot = next;
+            position -= tree[next - 1];
+        }
+    }
+    return slot;
+}
+
+ORIGIN_INLINE int fenwick_total(const fenwick *f, int c)
+{
+    const int *tree = f->tree + (size_t)c * f->capacity;
+    int sum = 0;
+    for (int i = f->capacity; i > 0; i -= i & -i)
+    {
+        sum += tree[i - 1];
+    }
+    return sum;
+}
+
+void fenwick_reset(fenwick *f, int capacity)
+{
+    int new_capacity = f->capacity > 0 ? f->capacity : 1;
+    while (new_capacity < capacity)
+    {
+        new_capacity <<= 1;
+    }
+    const size_t length = (size_t)f->communities * new_capacity;
+    if (new_capacity != f->capacity)
+    {
+        free(f->tree);
+        f->tree = (int*)malloc(length * sizeof(int));
+        f->capacity = new_capacity;
+    }
+    memset(f->tree, 0, length * sizeof(int));
+}
+
+void fenwick_build(fenwick *f, int c)
+{
+    int *tree = f->tree + (size_t)c * f->capacity;
+    const int capacity = f->capacity;
+    for (int i = 1; i <= capacity; ++i)
+    {
+        const int parent = i + (i & -i);
+        if (parent <= capacity)
+        {
+            tree[parent - 1] += tree[i - 1];
+        }
+    }
+}
+
+void fenwick_free(fenwick *f)
+{
+    free(f->tree);
+    f->tree = NULL;
+    f->capacity = 0;
+}
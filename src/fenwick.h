@@ -0,0 +1,43 @@
+#ifndef FENWICK_H_
+#define FENWICK_H_
+
+/**
+ * Cumulative abundances of a set of slots in every community, stored as
+ * one Fenwick (binary indexed) tree per community. Updates and searches
+ * are \f$O(\log n)\f$.
+ */
+typedef struct
+{
+    int communities; /** Number of communities. */
+
+    int capacity; /** Number of slots per community (always a power of 2). */
+
+    int *tree; /** The trees, 'capacity' ints per community (community-major). */
+}
+fenwick;
+
+/** Initialize empty trees (all slots at 0) with at least 'capacity' slots. */
+void fenwick_init(fenwick *f, int communities, int capacity);
+
+/** Add 'delta' to the abundance of 'slot' in community 'c'. \f$O(\log n)\f$. */
+void fenwick_add(fenwick *f, int c, int slot, int delta);
+
+/** Return the smallest slot whose cumulative abundance in community 'c' is greater than 'position'. \f$O(\log n)\f$. */
+int fenwick_find(const fenwick *f, int c, int position);
+
+/** Return the sum of the abundances of community 'c'. \f$O(\log n)\f$. */
+int fenwick_total(const fenwick *f, int c);
+
+/** Set all slots to 0 and make sure there are at least 'capacity' slots. */
+void fenwick_reset(fenwick *f, int capacity);
+
+/**
+ * Turn the raw abundances stored in the tree of community 'c' (slot i at
+ * index i) into a proper Fenwick tree. \f$O(n)\f$.
+ */
+void fenwick_build(fenwick *f, int c);
+
+/** Free the memory of the struct. */
+void fenwick_free(fenwick *f);
+
+#endif
@@ -0,0 +1,758 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include "common.h"
+#include "ivector.h"
+#include "rng.h"
+#include "graph.h"
+#include "migration.h"
+#include "fenwick.h"
+#include "species.h"
+#include "specieslist.h"
+#include "speciespool.h"
+#include "speciesindex.h"
+#include "metacom.h"
+#include "individuals.h"
+#include "kernel.h"
+#include "checkpoint.h"
+#include "forward.h"
+
+void forward_init(forward *fw, int model, int state, int sampler, int migration, bool skip, double omega, species_list *list, const graph_csr *g, const migration_sampler *ms, double **cumul, rng_stream **rngs, int j_per_c, double mu, double s)
+{
+    fw->model = model;
+    fw->state = state;
+    fw->migration = migration;
+    fw->communities = g->num_v;
+    fw->j_per_c = j_per_c;
+    fw->mu = mu;
+    fw->s = s;
+    fw->g = g;
+    fw->ms = ms;
+    fw->cumul = cumul;
+    fw->rngs = rngs;
+    fw->list = list;
+    fw->list_index = false;
+    fw->events = 0;
+    fw->migrations = 0;
+    fw->expected_migrations = 0.0;
+    fw->mutation_trials = 0;
+    fw->mutations = 0;
+    fw->seconds = 0.0;
+
+    // Proper neighbours and probability of migration (loops have a weight of 1.0, proper edges 'omega'):
+    const int communities = fw->communities;
+    fw->skip = skip;
+    fw->p_migration = (double*)malloc(communities * sizeof(double));
+    fw->offset = (int*)malloc((communities + 1) * sizeof(int));
+    fw->neighbours = (int*)malloc((graph_csr_edges(g) > 0 ? graph_csr_edges(g) : 1) * sizeof(int));
+    fw->offset[0] = 0;
+    for (int c = 0; c < communities; ++c)
+    {
+        int loops = 0;
+        fw->offset[c + 1] = fw->offset[c];
+        for (int e = g->offset[c]; e < g->offset[c + 1]; ++e)
+        {
+            if (g->target[e] == c)
+            {
+                ++loops;
+            }
+            else
+            {
+                fw->neighbours[fw->offset[c + 1]++] = g->target[e];
+            }
+        }
+        const double proper = (fw->offset[c + 1] - fw->offset[c]) * omega;
+        fw->p_migration[c] = proper > 0.0 ? proper / (loops + proper) : 0.0;
+    }
+    fw->until_migration = NULL;
+    fw->until_mutation = NULL;
+    if (skip)
+    {
+        fw->until_migration = (int64_t*)malloc(communities * sizeof(int64_t));
+        fw->until_mutation = (int64_t*)malloc(communities * sizeof(int64_t));
+        for (int c = 0; c < communities; ++c)
+        {
+            fw->until_migration[c] = rng_stream_geometric(rngs[c], fw->p_migration[c]);
+            fw->until_mutation[c] = rng_stream_geometric(rngs[c], mu);
+        }
+    }
+
+    if (state == STATE_LIST)
+    {
+        // Index of the abundances (only used by the Fenwick sampler):
+        fw->list_index = sampler == SAMPLER_FENWICK;
+        if (fw->list_index)
+        {
+            species_index_init(&fw->index, list, fw->communities);
+        }
+        if (model == MODEL_BDM_NEUTRAL)
+        {
+            fw->run_k = skip ? forward_list_neutral_skip : forward_list_neutral;
+        }
+        else
+        {
+            fw->run_k = skip ? forward_list_selection_skip : forward_list_selection;
+        }
+    }
+    else
+    {
+        metacom_init_from_list(&fw->mc, list, state == STATE_DENSE && sampler == SAMPLER_FENWICK);
+        if (state == STATE_INDIVIDUALS)
+        {
+            individuals_init(&fw->ind, &fw->mc, j_per_c);
+        }
+        if (model == MODEL_BDM_NEUTRAL)
+        {
+            fw->run_k = skip ? forward_dense_neutral_skip : forward_dense_neutral;
+        }
+        else
+        {
+            fw->run_k = skip ? forward_dense_selection_skip : forward_dense_selection;
+        }
+    }
+}
+
+void forward_set_stats(forward *fw, int *speciation_events, int *extinction_events, int *total_species, int *speciation_per_c, int *extinction_per_c, ivector *lifespan, ivector *pop_size)
+{
+    fw->speciation_events = speciation_events;
+    fw->extinction_events = extinction_events;
+    fw->total_species = total_species;
+    fw->speciation_per_c = speciation_per_c;
+    fw->extinction_per_c = extinction_per_c;
+    fw->lifespan = lifespan;
+    fw->pop_size = pop_size;
+}
+
+void forward_run_k(forward *fw, int k)
+{
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    fw->run_k(fw, k);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    fw->seconds += (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    fw->events += 1000L * fw->j_per_c * fw->communities;
+    for (int c = 0; c < fw->communities; ++c)
+    {
+        fw->expected_migrations += 1000.0 * fw->j_per_c * fw->p_migration[c];
+    }
+}
+
+species_list *forward_species(const forward *fw)
+{
+    return fw->state == STATE_LIST ? fw->list : metacom_to_species_list(&fw->mc);
+}
+
+void forward_print_kernel(const forward *fw, FILE *out)
+{
+    fprintf(out, "  <kernel>\n");
+    fprintf(out, "    <name>%s</name>\n", kernel_name(fw->model));
+    fprintf(out, "    <events>%ld</events>\n", fw->events);
+    fprintf(out, "    <seconds>%.4f</seconds>\n", fw->seconds);
+    fprintf(out, "    <ns_per_event>%.2f</ns_per_event>\n", fw->events > 0 ? fw->seconds * 1e9 / fw->events : 0.0);
+    fprintf(out, "    <skip_ahead>%s</skip_ahead>\n", fw->skip ? "yes" : "no");
+    fprintf(out, "    <migrations>%ld</migrations>\n", fw->migrations);
+    fprintf(out, "    <expected_migrations>%.1f</expected_migrations>\n", fw->expected_migrations);
+    fprintf(out, "    <mutation_trials>%ld</mutation_trials>\n", fw->mutation_trials);
+    fprintf(out, "    <mutations>%ld</mutations>\n", fw->mutations);
+    fprintf(out, "    <expected_mutations>%.1f</expected_mutations>\n", fw->mutation_trials * fw->mu);
+    fprintf(out, "  </kernel>\n");
+}
+
+void forward_save(const forward *fw, checkpoint *ck)
+{
+    const int communities = fw->communities;
+    checkpoint_put(ck, &fw->events, sizeof(long));
+    checkpoint_put(ck, &fw->migrations, sizeof(long));
+    checkpoint_put(ck, &fw->expected_migrations, sizeof(double));
+    checkpoint_put(ck, &fw->mutation_trials, sizeof(long));
+    checkpoint_put(ck, &fw->mutations, sizeof(long));
+    checkpoint_put(ck, &fw->seconds, sizeof(double));
+    if (fw->skip)
+    {
+        checkpoint_put(ck, fw->until_migration, communities * sizeof(int64_t));
+        checkpoint_put(ck, fw->until_mutation, communities * sizeof(int64_t));
+    }
+    if (fw->state == STATE_LIST)
+    {
+        // The species in the order of the list, extinct ones included:
+        checkpoint_put_int(ck, fw->list->size);
+        checkpoint_put_int(ck, fw->list->pending);
+        for (slnode *it = fw->list->head; it != NULL; it = it->next)
+        {
+            const species *sp = it->sp;
+            checkpoint_put_int(ck, sp->birth);
+            checkpoint_put_int(ck, sp->n_genotypes);
+            checkpoint_put_ints(ck, sp->n, communities);
+            for (int i = 0; i < sp->n_genotypes; ++i)
+            {
+                checkpoint_put_ints(ck, sp->genotypes[i], communities);
+            }
+        }
+    }
+    else
+    {
+        const metacom *mc = &fw->mc;
+        checkpoint_put_int(ck, mc->n_genotypes);
+        checkpoint_put_int(ck, mc->capacity);
+        checkpoint_put_int(ck, mc->size);
+        checkpoint_put_int(ck, mc->end);
+        checkpoint_put(ck, mc->counts, (size_t)communities * mc->capacity * mc->stride * sizeof(int));
+        checkpoint_put_ints(ck, mc->birth, mc->capacity);
+        checkpoint_put_ivector(ck, &mc->free_slots);
+        if (fw->state == STATE_INDIVIDUALS)
+        {
+            checkpoint_put(ck, fw->ind.entries, (size_t)communities * fw->j_per_c * sizeof(unsigned int));
+        }
+    }
+}
+
+bool forward_restore(forward *fw, checkpoint *ck)
+{
+    const int communities = fw->communities;
+    checkpoint_get(ck, &fw->events, sizeof(long));
+    checkpoint_get(ck, &fw->migrations, sizeof(long));
+    checkpoint_get(ck, &fw->expected_migrations, sizeof(double));
+    checkpoint_get(ck, &fw->mutation_trials, sizeof(long));
+    checkpoint_get(ck, &fw->mutations, sizeof(long));
+    checkpoint_get(ck, &fw->seconds, sizeof(double));
+    if (fw->skip)
+    {
+        checkpoint_get(ck, fw->until_migration, communities * sizeof(int64_t));
+        checkpoint_get(ck, fw->until_mutation, communities * sizeof(int64_t));
+    }
+    if (fw->state == STATE_LIST)
+    {
+        species_list *list = fw->list;
+        while (list->size > 0)
+        {
+            species_list_rmv_next(list, NULL);
+        }
+        const int size = checkpoint_get_int(ck);
+        checkpoint_get_int(ck); // The pending extinctions are queued again below
+        list->pending = 0;
+        for (int k = 0; k < size && ck->ok; ++k)
+        {
+            const int birth = checkpoint_get_int(ck);
+            const int n_genotypes = checkpoint_get_int(ck);
+            species *sp = list->pool != NULL ? species_pool_species(list->pool, birth) : species_init(communities, birth, n_genotypes);
+            if (sp->n_genotypes != n_genotypes)
+            {
+                ck->ok = false;
+            }
+            else
+            {
+                checkpoint_get_ints(ck, sp->n, communities);
+                for (int i = 0; i < n_genotypes; ++i)
+                {
+                    checkpoint_get_ints(ck, sp->genotypes[i], communities);
+                }
+            }
+            sp->total = 0;
+            for (int c = 0; c < communities; ++c)
+            {
+                sp->total += sp->n[c];
+            }
+            species_list_add(list, sp);
+            if (sp->total == 0)
+            {
+                species_list_add_pending(list, sp);
+            }
+        }
+        if (fw->list_index)
+        {
+            species_index_free(&fw->index);
+            species_index_init(&fw->index, list, communities);
+        }
+    }
+    else
+    {
+        const bool indexed = fw->mc.index != NULL;
+        metacom_free(&fw->mc);
+        const int n_genotypes = checkpoint_get_int(ck);
+        const int capacity = checkpoint_get_int(ck);
+        metacom *mc = &fw->mc;
+        metacom_init(mc, communities, n_genotypes, capacity > 0 ? capacity : 1, indexed);
+        mc->size = checkpoint_get_int(ck);
+        mc->end = checkpoint_get_int(ck);
+        if (mc->capacity != capacity)
+        {
+            ck->ok = false;
+        }
+        else
+        {
+            checkpoint_get(ck, mc->counts, (size_t)communities * mc->capacity * mc->stride * sizeof(int));
+            checkpoint_get_ints(ck, mc->birth, mc->capacity);
+            checkpoint_get_ivector(ck, &mc->free_slots);
+        }
+        metacom_build_totals(mc);
+        if (indexed)
+        {
+            metacom_build_index(mc);
+        }
+        if (fw->state == STATE_INDIVIDUALS)
+        {
+            checkpoint_get(ck, fw->ind.entries, (size_t)communities * fw->j_per_c * sizeof(unsigned int));
+        }
+    }
+    return ck->ok;
+}
+
+void forward_redraw_countdowns(forward *fw)
+{
+    for (int c = 0; fw->skip && c < fw->communities; ++c)
+    {
+        fw->until_migration[c] = rng_stream_geometric(fw->rngs[c], fw->p_migration[c]);
+        fw->until_mutation[c] = rng_stream_geometric(fw->rngs[c], fw->mu);
+    }
+}
+
+void forward_free(forward *fw)
+{
+    free(fw->p_migration);
+    free(fw->offset);
+    free(fw->neighbours);
+    free(fw->until_migration);
+    free(fw->until_mutation);
+    if (fw->list_index)
+    {
+        species_index_free(&fw->index);
+    }
+    if (fw->state != STATE_LIST)
+    {
+        metacom_free(&fw->mc);
+    }
+    if (fw->state == STATE_INDIVIDUALS)
+    {
+        individuals_free(&fw->ind);
+    }
+}
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions
+
+ORIGIN_INLINE int forward_origin(const forward *fw, int c, double r)
+{
+    if (fw->migration == MIGRATION_ALIAS)
+    {
+        return migration_sampler_draw(fw->ms, c, r);
+    }
+    int v1 = 0;
+    while (r > fw->cumul[c][v1])
+    {
+        ++v1;
+    }
+    return fw->g->target[fw->g->offset[c] + v1];
+}
+
+ORIGIN_INLINE int forward_migrant(const forward *fw, int c, rng_stream *rs)
+{
+    const int degree = fw->offset[c + 1] - fw->offset[c];
+    return fw->neighbours[fw->offset[c] + rng_stream_bounded(rs, degree)];
+}
+
+// 1000 generations on the list of species. Always inlined with constant
+// 'model' and 'skip', which gives one copy of the loops per combination.
+ORIGIN_FORCE_INLINE void forward_list_k(forward *fw, int k, const int model, const bool skip)
+{
+    const int communities = fw->communities;
+    const int j_per_c = fw->j_per_c;
+    const double mu = fw->mu;
+    const double s = fw->s;
+    species_list *list = fw->list;
+    species_index *index = &fw->index;
+    const bool list_index = fw->list_index;
+    long migrations = 0;
+    long mutation_trials = 0;
+    long mutations = 0;
+    species *s0; // species0
+    species *s1; // species1
+    int g0 = 0;
+    int g1 = 0;
+    slnode *it;
+
+    fw->extinction_events[k] = 0;
+    fw->speciation_events[k] = 0;
+
+    /////////////////////////////////////////////
+    // 1 000 generations                       //
+    /////////////////////////////////////////////
+    for (int gen = 0; gen < 1000; ++gen)
+    {
+        const int current_date = (k * 1000) + gen;
+        /////////////////////////////////////////////
+        // A single generation                     //
+        /////////////////////////////////////////////
+        for (int t = 0; t < j_per_c; ++t)
+        {
+            /////////////////////////////////////////////
+            // A single time step (for each community) //
+            /////////////////////////////////////////////
+            for (int c = 0; c < communities; ++c)
+            {
+                rng_stream *rs = fw->rngs[c];
+                // Select the species and genotype of the individual to be replaced
+                int position = rng_stream_bounded(rs, j_per_c);
+                if (list_index)
+                {
+                    s0 = species_index_find(index, c, position);
+                }
+                else
+                {
+                    it = list->head;
+                    int cumul_n = it->sp->n[c];
+                    while (cumul_n <= position)
+                    {
+                        it = it->next;
+                        cumul_n += it->sp->n[c];
+                    }
+                    s0 = it->sp;
+                }
+                position = rng_stream_bounded(rs, s0->n[c]);
+                if (position < s0->genotypes[0][c])
+                {
+                    g0 = 0;
+                }
+                else if (position < (s0->genotypes[0][c] + s0->genotypes[1][c]))
+                {
+                    g0 = 1;
+                }
+                else
+                {
+                    g0 = 2;
+                }
+                // Choose the vertex for the individual
+                int v1;
+                if (!skip)
+                {
+                    v1 = forward_origin(fw, c, rng_stream_uniform(rs));
+                }
+                else if (fw->until_migration[c] > 0 && --fw->until_migration[c] == 0)
+                {
+                    v1 = forward_migrant(fw, c, rs);
+                    fw->until_migration[c] = rng_stream_geometric(rs, fw->p_migration[c]);
+                }
+                else
+                {
+                    v1 = c;
+                }
+                // species of the new individual
+                position = rng_stream_bounded(rs, j_per_c);
+                if (list_index)
+                {
+                    s1 = species_index_find(index, v1, position);
+                }
+                else
+                {
+                    it = list->head;
+                    int cumul_n = it->sp->n[v1];
+                    while (cumul_n <= position)
+                    {
+                        it = it->next;
+                        cumul_n += it->sp->n[v1];
+                    }
+                    s1 = it->sp;
+                }
+                if (v1 == c) // local remplacement
+                {
+                    g1 = kernel_genotype(model, rng_stream_uniform(rs), s1->genotypes[0][v1], s1->genotypes[1][v1], s1->genotypes[2][v1], s);
+                    if (g1 < 2)
+                    {
+                        ++mutation_trials;
+                        if (skip ? fw->until_mutation[c] > 0 && --fw->until_mutation[c] == 0 : rng_stream_uniform(rs) < mu)
+                        {
+                            ++g1;
+                            ++mutations;
+                            if (skip)
+                            {
+                                fw->until_mutation[c] = rng_stream_geometric(rs, mu);
+                            }
+                        }
+                    }
+                }
+                else
+                { // Migration event
+                    g1 = 0;
+                    ++migrations;
+                }
+                // Apply the changes
+                s0->n[c]--;
+                s0->genotypes[g0][c]--;
+                s1->n[c]++;
+                s1->genotypes[g1][c]++;
+                s1->total++;
+                if (--s0->total == 0)
+                {
+                    species_list_add_pending(list, s0);
+                }
+                if (list_index && s0 != s1)
+                {
+                    species_index_update(index, s0, c, -1);
+                    species_index_update(index, s1, c, 1);
+                }
+
+                ////////////////////////////////////////////
+                // Check for local extinction             //
+                ////////////////////////////////////////////
+                if (s0->n[c] == 0)
+                {
+                    fw->extinction_per_c[c]++;
+                }
+                ////////////////////////////////////////////
+                // Check for speciation                   //
+                ////////////////////////////////////////////
+                else if (s0->genotypes[2][c] > 0 && s0->genotypes[0][c] == 0 && s0->genotypes[1][c] == 0)
+                {
+                    // Add the new species
+                    species_list_add(list, list->pool != NULL ? species_pool_species(list->pool, current_date) : species_init(communities, current_date, 3));
+                    if (list_index)
+                    {
+                        species_index_add(index, list, list->tail->sp);
+                    }
+
+                    const int pop = s0->n[c];
+                    list->tail->sp->n[c] = pop;
+                    list->tail->sp->total = pop;
+                    list->tail->sp->genotypes[0][c] = pop;
+                    s0->n[c] = 0;
+                    s0->genotypes[2][c] = 0;
+                    s0->total -= pop;
+                    if (s0->total == 0)
+                    {
+                        species_list_add_pending(list, s0);
+                    }
+                    if (list_index)
+                    {
+                        species_index_update(index, list->tail->sp, c, pop);
+                        species_index_update(index, s0, c, -pop);
+                    }
+
+                    // To keep info on patterns of speciation...
+                    ivector_add(fw->pop_size, pop);
+                    ++fw->speciation_events[k];
+                    ++fw->speciation_per_c[c];
+                }
+
+            } // End 'c'
+
+        } // End 't'
+
+        // Remove the species that went extinct during the generation and store the number of extinctions.
+        fw->extinction_events[k] += species_list_rmv_pending(list, fw->lifespan, current_date);
+
+    } // End 'g'
+
+    fw->total_species[k] = list->size;
+    fw->migrations += migrations;
+    fw->mutation_trials += mutation_trials;
+    fw->mutations += mutations;
+}
+
+// Same model as forward_list_k, but the abundances and genotypes of all
+// species live in one block and species are identified by slots. With the
+// arrays of individuals, the individuals to replace and the parents are
+// read directly from the arrays and the counts are only used for fitness,
+// speciation and extinction.
+ORIGIN_FORCE_INLINE void forward_dense_k(forward *fw, int k, const int model, const bool skip)
+{
+    const int communities = fw->communities;
+    const int j_per_c = fw->j_per_c;
+    const double mu = fw->mu;
+    const double s = fw->s;
+    metacom *mc = &fw->mc;
+    individuals *ind = &fw->ind;
+    const bool use_ind = fw->state == STATE_INDIVIDUALS;
+    long migrations = 0;
+    long mutation_trials = 0;
+    long mutations = 0;
+    int sl0 = 0; // Slot of species0
+    int sl1 = 0; // Slot of species1
+    int g0 = 0;
+    int g1 = 0;
+
+    fw->extinction_events[k] = 0;
+    fw->speciation_events[k] = 0;
+
+    for (int gen = 0; gen < 1000; ++gen)
+    {
+        const int current_date = (k * 1000) + gen;
+
+        for (int t = 0; t < j_per_c; ++t)
+        {
+            for (int c = 0; c < communities; ++c)
+            {
+                rng_stream *rs = fw->rngs[c];
+                // Select the species and genotype of the individual to be replaced
+                const int position0 = rng_stream_bounded(rs, j_per_c);
+                int position = position0;
+                if (use_ind)
+                {
+                    const unsigned int e = individuals_community(ind, c)[position0];
+                    sl0 = individuals_slot(e);
+                    g0 = individuals_genotype(e);
+                }
+                else if (mc->index != NULL)
+                {
+                    sl0 = fenwick_find(mc->index, c, position);
+                }
+                else
+                {
+                    const int *cell = metacom_cell(mc, c, 0);
+                    int cumul_n = cell[0];
+                    for (sl0 = 0; cumul_n <= position; cumul_n += cell[0])
+                    {
+                        ++sl0;
+                        cell += mc->stride;
+                    }
+                }
+                int *n0 = metacom_cell(mc, c, sl0);
+                if (!use_ind)
+                {
+                    position = rng_stream_bounded(rs, n0[0]);
+                    if (position < n0[1])
+                    {
+                        g0 = 0;
+                    }
+                    else if (position < (n0[1] + n0[2]))
+                    {
+                        g0 = 1;
+                    }
+                    else
+                    {
+                        g0 = 2;
+                    }
+                }
+                // Choose the vertex for the individual
+                int v1;
+                if (!skip)
+                {
+                    v1 = forward_origin(fw, c, rng_stream_uniform(rs));
+                }
+                else if (fw->until_migration[c] > 0 && --fw->until_migration[c] == 0)
+                {
+                    v1 = forward_migrant(fw, c, rs);
+                    fw->until_migration[c] = rng_stream_geometric(rs, fw->p_migration[c]);
+                }
+                else
+                {
+                    v1 = c;
+                }
+                // species of the new individual
+                position = rng_stream_bounded(rs, j_per_c);
+                if (use_ind)
+                {
+                    sl1 = individuals_slot(individuals_community(ind, v1)[position]);
+                }
+                else if (mc->index != NULL)
+                {
+                    sl1 = fenwick_find(mc->index, v1, position);
+                }
+                else
+                {
+                    const int *cell = metacom_cell(mc, v1, 0);
+                    int cumul_n = cell[0];
+                    for (sl1 = 0; cumul_n <= position; cumul_n += cell[0])
+                    {
+                        ++sl1;
+                        cell += mc->stride;
+                    }
+                }
+                if (v1 == c) // local remplacement
+                {
+                    const int *n1 = metacom_cell(mc, v1, sl1);
+                    g1 = kernel_genotype(model, rng_stream_uniform(rs), n1[1], n1[2], n1[3], s);
+                    if (g1 < 2)
+                    {
+                        ++mutation_trials;
+                        if (skip ? fw->until_mutation[c] > 0 && --fw->until_mutation[c] == 0 : rng_stream_uniform(rs) < mu)
+                        {
+                            ++g1;
+                            ++mutations;
+                            if (skip)
+                            {
+                                fw->until_mutation[c] = rng_stream_geometric(rs, mu);
+                            }
+                        }
+                    }
+                }
+                else
+                { // Migration event
+                    g1 = 0;
+                    ++migrations;
+                }
+                // Apply the changes
+                int *n1 = metacom_cell(mc, c, sl1);
+                n0[0]--;
+                n0[1 + g0]--;
+                n1[0]++;
+                n1[1 + g1]++;
+                metacom_transfer(mc, sl0, sl1, 1);
+                if (use_ind)
+                {
+                    individuals_community(ind, c)[position0] = individuals_entry(sl1, g1);
+                }
+                else if (mc->index != NULL && sl0 != sl1)
+                {
+                    fenwick_add(mc->index, c, sl0, -1);
+                    fenwick_add(mc->index, c, sl1, 1);
+                }
+
+                // Check for local extinction
+                if (n0[0] == 0)
+                {
+                    fw->extinction_per_c[c]++;
+                }
+                // Check for speciation
+                else if (n0[3] > 0 && n0[1] == 0 && n0[2] == 0)
+                {
+                    const int pop = n0[0];
+                    const int slot = metacom_add(mc, current_date); // May move the block
+                    n0 = metacom_cell(mc, c, sl0);
+                    int *new_sp = metacom_cell(mc, c, slot);
+                    new_sp[0] = pop;
+                    new_sp[1] = pop;
+                    n0[0] = 0;
+                    n0[3] = 0;
+                    metacom_transfer(mc, sl0, slot, pop);
+                    if (use_ind)
+                    {
+                        individuals_relabel(ind, c, sl0, slot, 0);
+                    }
+                    else if (mc->index != NULL)
+                    {
+                        fenwick_add(mc->index, c, slot, pop);
+                        fenwick_add(mc->index, c, sl0, -pop);
+                    }
+
+                    // To keep info on patterns of speciation...
+                    ivector_add(fw->pop_size, pop);
+                    ++fw->speciation_events[k];
+                    ++fw->speciation_per_c[c];
+                }
+
+            } // End 'c'
+
+        } // End 't'
+
+        // Remove extinct species and store the number of extinctions.
+        fw->extinction_events[k] += metacom_rmv_extinct(mc, fw->lifespan, current_date);
+
+    } // End 'g'
+
+    fw->total_species[k] = mc->size;
+    fw->migrations += migrations;
+    fw->mutation_trials += mutation_trials;
+    fw->mutations += mutations;
+}
+
+// One instance of the loops per state, model and skip-ahead:
+#define FORWARD_LOOPS(name, loops, model, skip)    void name(forward *fw, int k) { loops(fw, k, model, skip); }
+
+FORWARD_LOOPS(forward_list_neutral, forward_list_k, MODEL_BDM_NEUTRAL, false)
+FORWARD_LOOPS(forward_list_selection, forward_list_k, MODEL_BDM_SELECTION, false)
+FORWARD_LOOPS(forward_list_neutral_skip, forward_list_k, MODEL_BDM_NEUTRAL, true)
+FORWARD_LOOPS(forward_list_selection_skip, forward_list_k, MODEL_BDM_SELECTION, true)
+FORWARD_LOOPS(forward_dense_neutral, forward_dense_k, MODEL_BDM_NEUTRAL, false)
+FORWARD_LOOPS(forward_dense_selection, forward_dense_k, MODEL_BDM_SELECTION, false)
+FORWARD_LOOPS(forward_dense_neutral_skip, forward_dense_k, MODEL_BDM_NEUTRAL, true)
+FORWARD_LOOPS(forward_dense_selection_skip, forward_dense_k, MODEL_BDM_SELECTION, true)
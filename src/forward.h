@@ -0,0 +1,182 @@
+#ifndef FORWARD_H_
+#define FORWARD_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "ivector.h"
+#include "rng.h"
+#include "graph.h"
+#include "migration.h"
+#include "specieslist.h"
+#include "speciesindex.h"
+#include "metacom.h"
+#include "individuals.h"
+#include "kernel.h"
+#include "checkpoint.h"
+
+#define SAMPLER_LINEAR         0
+#define SAMPLER_FENWICK        1
+
+#define MIGRATION_CUMULATIVE   0
+#define MIGRATION_ALIAS        1
+
+#define STATE_LIST             0
+#define STATE_DENSE            1
+#define STATE_INDIVIDUALS      2
+
+/**
+ * The sequential forward simulation: every replacement of every community,
+ * on a list of species (STATE_LIST) or on a metacom, with or without the
+ * arrays of individuals (STATE_DENSE, STATE_INDIVIDUALS).
+ *
+ * The loops over the generations, time steps and communities are compiled
+ * once per model, per state and with or without skip-ahead (see kernel.h).
+ * The version used is picked once by forward_init, so the loops never test
+ * the model.
+ *
+ * With skip-ahead, each community counts down the replacements left until
+ * its next migration and the mutation trials (local births from aa or Ab)
+ * left until its next mutation. The countdowns are drawn from geometric
+ * distributions, which gives the same process as one Bernoulli draw per
+ * event, but the usual local replacement draws no number for the
+ * migration and the mutation. A countdown of 0 (a community without
+ * proper neighbours, omega = 0 or mu = 0) is never decremented, so the
+ * event never happens. Migrants come from a neighbour picked
+ * uniformly, since all proper edges have the same weight.
+ */
+typedef struct forward_
+{
+    int model; /** MODEL_BDM_NEUTRAL or MODEL_BDM_SELECTION. */
+
+    int state; /** Storage of the abundances and genotypes. */
+
+    int migration; /** Method used to pick the community of origin. */
+
+    int communities; /** Number of communities. */
+
+    int j_per_c; /** Number of individuals per community. */
+
+    double mu; /** Mutation rate. */
+
+    double s; /** Selection coefficient. */
+
+    const graph_csr *g; /** The metacommunity. */
+
+    const migration_sampler *ms; /** Alias tables (with MIGRATION_ALIAS). */
+
+    double **cumul; /** Cumulative lists (with MIGRATION_CUMULATIVE). */
+
+    bool skip; /** True for skip-ahead. */
+
+    double *p_migration; /** Probability that the parent comes from another community, per community. */
+
+    int *neighbours; /** Proper neighbours of the communities, from neighbours[offset[c]] to neighbours[offset[c + 1] - 1]. */
+
+    int *offset; /** First neighbour of each community ('communities' + 1 elements). */
+
+    int64_t *until_migration; /** Replacements left until the next migration, per community (skip-ahead only, 0 = never). */
+
+    int64_t *until_mutation; /** Mutation trials left until the next mutation, per community (skip-ahead only, 0 = never). */
+
+    rng_stream **rngs; /** Random stream of each community. */
+
+    species_list *list; /** The species (with STATE_LIST). */
+
+    bool list_index; /** True if 'index' is used to pick individuals in the list. */
+
+    species_index index; /** Abundances of the list (with 'list_index'). */
+
+    metacom mc; /** The species (with STATE_DENSE and STATE_INDIVIDUALS). */
+
+    individuals ind; /** The individuals (with STATE_INDIVIDUALS). */
+
+    int *speciation_events; /** Speciation events per 1000 generations (owned by the caller). */
+
+    int *extinction_events; /** Extinctions per 1000 generations (owned by the caller). */
+
+    int *total_species; /** Number of species per 1000 generations (owned by the caller). */
+
+    int *speciation_per_c; /** Speciation events per community (owned by the caller). */
+
+    int *extinction_per_c; /** Local extinctions per community (owned by the caller). */
+
+    ivector *lifespan; /** Lifespan of the extinct species (owned by the caller). */
+
+    ivector *pop_size; /** Population size at speciation (owned by the caller). */
+
+    long events; /** Number of replacements so far. */
+
+    long migrations; /** Number of migrations so far. */
+
+    double expected_migrations; /** Expected number of migrations. */
+
+    long mutation_trials; /** Number of local births from aa or Ab so far. */
+
+    long mutations; /** Number of mutations so far. */
+
+    double seconds; /** Time spent in the replacements. */
+
+    void (*run_k)(struct forward_ *fw, int k); /** The specialised loops. */
+}
+forward;
+
+/**
+ * Initialize the simulation from the initial species. With STATE_LIST the
+ * list is the state of the simulation, otherwise it is copied. 'ms' or
+ * 'cumul' is used depending on 'migration'.
+ */
+void forward_init(forward *fw, int model, int state, int sampler, int migration, bool skip, double omega, species_list *list, const graph_csr *g, const migration_sampler *ms, double **cumul, rng_stream **rngs, int j_per_c, double mu, double s);
+
+/** Set the arrays and vectors where the statistics are stored (see the fields of the struct). */
+void forward_set_stats(forward *fw, int *speciation_events, int *extinction_events, int *total_species, int *speciation_per_c, int *extinction_per_c, ivector *lifespan, ivector *pop_size);
+
+/** Run the 'k'th group of 1000 generations. */
+void forward_run_k(forward *fw, int k);
+
+/** Return the final species: the list itself with STATE_LIST, a new list otherwise. */
+species_list *forward_species(const forward *fw);
+
+/** Print the kernel used, its cost per event, and the numbers of migrations and mutations (observed and expected). */
+void forward_print_kernel(const forward *fw, FILE *out);
+
+/** Append the state of the simulation (species, countdowns and counters) to a checkpoint. */
+void forward_save(const forward *fw, checkpoint *ck);
+
+/**
+ * Replace the state of a simulation initialized with the same parameters
+ * by the one read from a checkpoint, and return false if the checkpoint
+ * doesn't match. The statistics and the random streams are not part of it.
+ */
+bool forward_restore(forward *fw, checkpoint *ck);
+
+/**
+ * Draw new skip-ahead countdowns from the random streams of the communities
+ * (nothing without skip-ahead), e.g. for the replicates branched from a
+ * burn-in. The waiting times are memoryless, so the process is the same.
+ */
+void forward_redraw_countdowns(forward *fw);
+
+/** Free the memory (but not the list of species). */
+void forward_free(forward *fw);
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions. You shouldn't need those.
+
+/** The loops specialised per state, model and skip-ahead (see FORWARD_LOOPS in forward.c). */
+void forward_list_neutral(forward *fw, int k);
+void forward_list_selection(forward *fw, int k);
+void forward_list_neutral_skip(forward *fw, int k);
+void forward_list_selection_skip(forward *fw, int k);
+void forward_dense_neutral(forward *fw, int k);
+void forward_dense_selection(forward *fw, int k);
+void forward_dense_neutral_skip(forward *fw, int k);
+void forward_dense_selection_skip(forward *fw, int k);
+
+/** Return the community of origin of a new individual in 'c', given a uniform deviate 'r'. */
+int forward_origin(const forward *fw, int c, double r);
+
+/** Return the community of origin of a migrant to 'c' (skip-ahead). */
+int forward_migrant(const forward *fw, int c, rng_stream *rs);
+
+#endif
@@ -1,11 +1,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <math.h>
 #include <float.h>
-#include <gsl/gsl_rng.h>
-#include <gsl/gsl_randist.h>
 #include "common.h"
+#include "rng.h"
 #include "graph.h"
 #include "utils.h"
 
@@ -175,43 +175,162 @@ int graph_has_edge(graph *g, int u, int v)
 int graph_strongly_connected(const graph *g)
 {
     const int num_v = g->num_v;
-    int *group = (int*)malloc(num_v * sizeof(int));
-
-    int u = 0;
-    for (; u < num_v; ++u) 
+    if (num_v == 0)
+    {
+        return TRUE;
+    }
+    // Tarjan's algorithm from vertex 0, with an explicit stack. It stops at
+    // the first strongly connected component found: the graph is strongly
+    // connected if it's the component of 0 and every vertex was reached
+    // (nothing was assigned to a component before, so all the vertices
+    // reached are still on Tarjan's stack).
+    int *index = (int*)malloc(num_v * sizeof(int));
+    int *low = (int*)malloc(num_v * sizeof(int));
+    int *next = (int*)malloc(num_v * sizeof(int)); // Next edge to follow.
+    int *call = (int*)malloc(num_v * sizeof(int)); // The path of the DFS.
+    for (int v = 0; v < num_v; ++v)
     {
-        int v = 0;
-        for (; v < num_v; ++v) 
+        index[v] = -1;
+    }
+    int visited = 0;
+    int top = 0;
+    index[0] = low[0] = visited++;
+    next[0] = 0;
+    call[top++] = 0;
+    int connected = FALSE;
+    while (top > 0)
+    {
+        const int u = call[top - 1];
+        if (next[u] < g->num_e[u])
         {
-            group[v] = FALSE;
+            const int v = g->adj_list[u][next[u]++];
+            if (index[v] < 0)
+            {
+                index[v] = low[v] = visited++;
+                next[v] = 0;
+                call[top++] = v;
+            }
+            else if (index[v] < low[u])
+            {
+                low[u] = index[v];
+            }
         }
-
-        group[u] = TRUE;
-        graph_test_cc(g, group, u); // Call recursive function
-
-        for (v = 0; v < num_v; ++v) 
+        else
         {
-            if (group[v] == FALSE) 
+            --top;
+            if (low[u] == index[u])
             {
-                free(group);
-                return FALSE;
+                connected = u == 0 && visited == num_v;
+                break;
+            }
+            const int parent = call[top - 1];
+            if (low[u] < low[parent])
+            {
+                low[parent] = low[u];
             }
         }
     }
-    free(group);
-    return TRUE;
+    free(index);
+    free(low);
+    free(next);
+    free(call);
+    return connected;
 }
 
 void graph_svg(const graph *g, double *x, double *y, double size, double offset, FILE *out)
 {
-    fprintf(out, "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">");
+    graph_csr csr;
+    graph_csr_init(&csr, g);
+    graph_csr_svg(&csr, x, y, size, offset, out);
+    graph_csr_free(&csr);
+}
+
+void graph_svg_abun(const graph *g, double *x, double *y, double size, double offset, double *abun, int color, FILE *out)
+{
+    graph_csr csr;
+    graph_csr_init(&csr, g);
+    graph_csr_svg_abun(&csr, x, y, size, offset, abun, color, out);
+    graph_csr_free(&csr);
+}
+
+void graph_graphml(const graph *g, FILE *out, unsigned int id)
+{
+    graph_csr csr;
+    graph_csr_init(&csr, g);
+    graph_csr_graphml(&csr, out, id);
+    graph_csr_free(&csr);
+}
+
+void graph_print(const graph *g, FILE *out)
+{
+    for (int i = 0; i < g->num_v; ++i) 
+    {
+        fprintf(out, "%5d -> ", i);
+        for (int e = 0; e < g->num_e[i]; ++e) 
+        {
+            fprintf(out, "%d ", g->adj_list[i][e]);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+void graph_free(graph *g)
+{
     const int num_v = g->num_v;
+    for (int i = 0; i < num_v; ++i) 
+    {
+        free(g->adj_list[i]);
+        free(g->w_list[i]);
+    }
+    free(g->adj_list);
+    g->adj_list = NULL;
+    free(g->w_list);
+    g->w_list = NULL;
+    free(g->num_e);
+    g->num_e = NULL;
+    free(g->capacity);
+    g->capacity = NULL;
+}
+
+void graph_csr_init(graph_csr *csr, const graph *g)
+{
+    const int num_v = g->num_v;
+    csr->num_v = num_v;
+    csr->offset = (int*)malloc((num_v + 1) * sizeof(int));
+    csr->offset[0] = 0;
+    for (int u = 0; u < num_v; ++u)
+    {
+        csr->offset[u + 1] = csr->offset[u] + g->num_e[u];
+    }
+    const int num_e = csr->offset[num_v];
+    csr->target = (int*)malloc((num_e > 0 ? num_e : 1) * sizeof(int));
+    csr->weight = (double*)malloc((num_e > 0 ? num_e : 1) * sizeof(double));
+    for (int u = 0; u < num_v; ++u)
+    {
+        memcpy(csr->target + csr->offset[u], g->adj_list[u], g->num_e[u] * sizeof(int));
+        memcpy(csr->weight + csr->offset[u], g->w_list[u], g->num_e[u] * sizeof(double));
+    }
+}
+
+ORIGIN_INLINE int graph_csr_edges(const graph_csr *csr)
+{
+    return csr->offset[csr->num_v];
+}
+
+ORIGIN_INLINE int graph_csr_outdegree(const graph_csr *csr, int u)
+{
+    return csr->offset[u + 1] - csr->offset[u];
+}
+
+void graph_csr_svg(const graph_csr *csr, double *x, double *y, double size, double offset, FILE *out)
+{
+    fprintf(out, "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">");
+    const int num_v = csr->num_v;
     for (int i = 0; i < num_v; ++i)
     {
-        const int num_e = g->num_e[i];
-        for (int j = 0; j < num_e; ++j)
+        for (int j = csr->offset[i]; j < csr->offset[i + 1]; ++j)
         {
-            const int e = g->adj_list[i][j];
+            const int e = csr->target[j];
             fprintf(out, "  <line x1=\"%f\" y1=\"%f\" x2=\"%f\" y2=\"%f\" style=\"stroke:rgb(0,0,0);stroke-width:2\"/>\n", offset + x[i] * size, offset + y[i] * size, offset + x[e] * size, offset + y[e] * size);
         }
     }
@@ -222,16 +341,15 @@ void graph_svg(const graph *g, double *x, double *y, double size, double offset,
     fprintf(out, "</svg>");
 }
 
-void graph_svg_abun(const graph *g, double *x, double *y, double size, double offset, double *abun, int color, FILE *out)
+void graph_csr_svg_abun(const graph_csr *csr, double *x, double *y, double size, double offset, double *abun, int color, FILE *out)
 {
     fprintf(out, "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">");
-    const int num_v = g->num_v;
+    const int num_v = csr->num_v;
     for (int i = 0; i < num_v; ++i)
     {
-        const int num_e = g->num_e[i];
-        for (int j = 0; j < num_e; ++j)
+        for (int j = csr->offset[i]; j < csr->offset[i + 1]; ++j)
         {
-            const int e = g->adj_list[i][j];
+            const int e = csr->target[j];
             fprintf(out, "  <line x1=\"%f\" y1=\"%f\" x2=\"%f\" y2=\"%f\" style=\"stroke:rgb(0,0,0);stroke-width:2\"/>\n", offset + x[i] * size, offset + y[i] * size, offset + x[e] * size, offset + y[e] * size);
         }
     }
@@ -244,9 +362,9 @@ void graph_svg_abun(const graph *g, double *x, double *y, double size, double of
     fprintf(out, "</svg>");
 }
 
-void graph_graphml(const graph *g, FILE *out, unsigned int id)
+void graph_csr_graphml(const graph_csr *csr, FILE *out, unsigned int id)
 {
-    const int num_v = g->num_v;
+    const int num_v = csr->num_v;
     fprintf(out, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
     fprintf(out, "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\"");
     fprintf(out, " xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"");
@@ -259,120 +377,66 @@ void graph_graphml(const graph *g, FILE *out, unsigned int id)
     }
     for (int i = 0; i < num_v; ++i)
     {
-        for (int e = 0; e < g->num_e[i]; ++e) 
+        for (int e = csr->offset[i]; e < csr->offset[i + 1]; ++e)
         {
-            fprintf(out, "    <edge source=\"v%d\" target=\"v%d\"/>\n", i, g->adj_list[i][e]);
+            fprintf(out, "    <edge source=\"v%d\" target=\"v%d\"/>\n", i, csr->target[e]);
         }
     }
     fprintf(out, "  </graph>\n");
     fprintf(out, "</graphml>\n");
 }
 
-void graph_print(const graph *g, FILE *out)
+void graph_csr_free(graph_csr *csr)
 {
-    for (int i = 0; i < g->num_v; ++i) 
-    {
-        fprintf(out, "%5d -> ", i);
-        for (int e = 0; e < g->num_e[i]; ++e) 
-        {
-            fprintf(out, "%d ", g->adj_list[i][e]);
-        }
-        fprintf(out, "\n");
-    }
+    free(csr->offset);
+    csr->offset = NULL;
+    free(csr->target);
+    csr->target = NULL;
+    free(csr->weight);
+    csr->weight = NULL;
 }
 
-void graph_free(graph *g)
-{
-    const int num_v = g->num_v;
-    for (int i = 0; i < num_v; ++i) 
-    {
-        free(g->adj_list[i]);
-        free(g->w_list[i]);
-    }
-    free(g->adj_list);
-    g->adj_list = NULL;
-    free(g->w_list);
-    g->w_list = NULL;
-    free(g->num_e);
-    g->num_e = NULL;
-    free(g->capacity);
-    g->capacity = NULL;
-}
-
-void graph_get_rgg(graph *g, int vertices, double r, double *x, double *y, gsl_rng *rng)
+void graph_get_rgg(graph *g, int vertices, double r, double *x, double *y, rng_stream *rng)
 {
     graph_init(g, vertices);
-
-    for (int i = 0; i < vertices; ++i)
-    {
-        x[i] = gsl_rng_uniform(rng);
-        y[i] = gsl_rng_uniform(rng);
-    }	
-    double d;
-    for (int i = 0; i < vertices; ++i) 
-    {
-        for (int j = 0; j < vertices; ++j) 
-        {
-            const double a = x[i] - x[j];
-            const double b = y[i] - y[j];
-            d = hypot(a, b);
-            if (d < r) 
-            {
-                graph_add_edge(g, i, j, r - d);
-            }
-        }
-    }
+    graph_rgg_points(vertices, 1.0, 1.0, x, y, rng);
+    graph_rgg_edges(g, vertices, 1.0, 1.0, r, x, y);
 }
 
-void graph_get_crgg(graph *g, int vertices, double r, double *x, double *y, gsl_rng *rng)
+void graph_get_crgg(graph *g, int vertices, double r, double *x, double *y, rng_stream *rng)
 {
-    graph_init(g, vertices);
-    graph_get_rgg(g, vertices, r, x, y, rng);
-
-    while (graph_strongly_connected(g) == FALSE)
+    // The points are redrawn until connected, the edges are only built for
+    // the last ones:
+    graph_rgg_points(vertices, 1.0, 1.0, x, y, rng);
+    while (graph_rgg_connected(vertices, 1.0, 1.0, r, x, y) == FALSE)
     {
-        graph_free(g);
-        graph_get_rgg(g, vertices, r, x, y, rng);
+        graph_rgg_points(vertices, 1.0, 1.0, x, y, rng);
     }
+    graph_init(g, vertices);
+    graph_rgg_edges(g, vertices, 1.0, 1.0, r, x, y);
 }
 
-void graph_get_rec_rgg(graph *g, int vertices, double width, double r, double *x, double *y, gsl_rng *rng)
+void graph_get_rec_rgg(graph *g, int vertices, double width, double r, double *x, double *y, rng_stream *rng)
 {
     graph_init(g, vertices);
 
     const double length = 1.0 / width; // A = l * w so l = 1 / w
 
-    for (int i = 0; i < vertices; ++i) 
-    {
-        x[i] = gsl_rng_uniform(rng) * length;
-        y[i] = gsl_rng_uniform(rng) * width;
-    }
-    double d;
-    for (int i = 0; i < vertices; ++i) 
-    {
-        for (int j = 0; j < vertices; ++j) 
-        {
-            const double a = x[i] - x[j];
-            const double b = y[i] - y[j];
-            d = hypot(a, b);
-            if (d < r) 
-            {
-                graph_add_edge(g, i, j, r - d);
-            }
-        }
-    }
+    graph_rgg_points(vertices, length, width, x, y, rng);
+    graph_rgg_edges(g, vertices, length, width, r, x, y);
 }
 
-void graph_get_rec_crgg(graph *g, int vertices, double width, double r, double *x, double *y, gsl_rng *rng)
+void graph_get_rec_crgg(graph *g, int vertices, double width, double r, double *x, double *y, rng_stream *rng)
 {
-    graph_init(g, vertices);
-    graph_get_rec_rgg(g, vertices, width, r, x, y, rng);
+    const double length = 1.0 / width; // A = l * w so l = 1 / w
 
-    while (graph_strongly_connected(g) == FALSE) 
+    graph_rgg_points(vertices, length, width, x, y, rng);
+    while (graph_rgg_connected(vertices, length, width, r, x, y) == FALSE)
     {
-        graph_free(g);
-        graph_get_rec_rgg(g, vertices, width, r, x, y, rng);
+        graph_rgg_points(vertices, length, width, x, y, rng);
     }
+    graph_init(g, vertices);
+    graph_rgg_edges(g, vertices, length, width, r, x, y);
 }
 
 void graph_get_complete(graph *g, int vertices)
@@ -416,19 +480,169 @@ void graph_get_star(graph *g, int vertices)
 ///////////////////////////////////////////////////////////////
 // 'Private' functions
 
-void graph_test_cc(const graph *g, int *group, int u)
+void graph_rgg_points(int vertices, double length, double width, double *x, double *y, rng_stream *rng)
 {
-    const int num_e = g->num_e[u];
-    int e = 0;
-    for (; e < num_e; ++e) 
+    for (int i = 0; i < vertices; ++i)
+    {
+        x[i] = rng_stream_uniform(rng) * length;
+        y[i] = rng_stream_uniform(rng) * width;
+    }
+}
+
+void graph_grid_init(graph_grid *grid, int vertices, double length, double width, double r, const double *x, const double *y)
+{
+    // Cells a bit larger than 'r', so two vertices closer than 'r' are
+    // always in the same or in adjacent cells (even with the rounding of the
+    // divisions), and no more cells than about 4 per vertex:
+    const int max_cells = 2 * (int)ceil(sqrt((double)vertices)) + 1;
+    // Clamped before the conversion (a tiny 'r' overflows an int):
+    const double nx = r > 0.0 ? length / (r * GRAPH_CELL_MARGIN) : 1.0;
+    const double ny = r > 0.0 ? width / (r * GRAPH_CELL_MARGIN) : 1.0;
+    const int mx = !(nx >= 1.0) ? 1 : (nx > max_cells ? max_cells : (int)nx);
+    const int my = !(ny >= 1.0) ? 1 : (ny > max_cells ? max_cells : (int)ny);
+    const double cx = length / mx;
+    const double cy = width / my;
+    grid->mx = mx;
+    grid->my = my;
+
+    // The vertices of each cell, in increasing order (a counting sort):
+    grid->cell = (int*)malloc((vertices > 0 ? vertices : 1) * sizeof(int));
+    grid->start = (int*)calloc(mx * my + 1, sizeof(int));
+    grid->items = (int*)malloc((vertices > 0 ? vertices : 1) * sizeof(int));
+    for (int i = 0; i < vertices; ++i)
     {
-        const int head = g->adj_list[u][e];
-        if (head != u && group[head] == FALSE)
+        int a = (int)(x[i] / cx);
+        int b = (int)(y[i] / cy);
+        a = a < 0 ? 0 : (a >= mx ? mx - 1 : a);
+        b = b < 0 ? 0 : (b >= my ? my - 1 : b);
+        grid->cell[i] = b * mx + a;
+        grid->start[grid->cell[i] + 1]++;
+    }
+    for (int c = 0; c < mx * my; ++c)
+    {
+        grid->start[c + 1] += grid->start[c];
+    }
+    int *next = (int*)malloc(mx * my * sizeof(int));
+    for (int c = 0; c < mx * my; ++c)
+    {
+        next[c] = grid->start[c];
+    }
+    for (int i = 0; i < vertices; ++i)
+    {
+        grid->items[next[grid->cell[i]]++] = i;
+    }
+    free(next);
+}
+
+int graph_grid_around(const graph_grid *grid, int i, int *candidates)
+{
+    const int a = grid->cell[i] % grid->mx;
+    const int b = grid->cell[i] / grid->mx;
+    int n = 0;
+    for (int v = (b > 0 ? b - 1 : 0); v <= (b < grid->my - 1 ? b + 1 : b); ++v)
+    {
+        for (int u = (a > 0 ? a - 1 : 0); u <= (a < grid->mx - 1 ? a + 1 : a); ++u)
+        {
+            const int c = v * grid->mx + u;
+            for (int k = grid->start[c]; k < grid->start[c + 1]; ++k)
+            {
+                candidates[n++] = grid->items[k];
+            }
+        }
+    }
+    return n;
+}
+
+void graph_grid_free(graph_grid *grid)
+{
+    free(grid->cell);
+    free(grid->start);
+    free(grid->items);
+}
+
+void graph_rgg_edges(graph *g, int vertices, double length, double width, double r, const double *x, const double *y)
+{
+    graph_grid grid;
+    graph_grid_init(&grid, vertices, length, width, r, x, y);
+
+    // Only the vertices of the 3x3 cells around 'i' are compared with it,
+    // sorted so the edges are added in the same order as a test of all the
+    // pairs (the order of the adjacency lists drives the migrations):
+    int *candidates = (int*)malloc((vertices > 0 ? vertices : 1) * sizeof(int));
+    for (int i = 0; i < vertices; ++i)
+    {
+        const int n = graph_grid_around(&grid, i, candidates);
+        qsort(candidates, n, sizeof(int), compare_int_asc);
+        for (int k = 0; k < n; ++k)
+        {
+            const int j = candidates[k];
+            const double d = hypot(x[i] - x[j], y[i] - y[j]);
+            if (d < r)
+            {
+                graph_add_edge(g, i, j, r - d);
+            }
+        }
+    }
+    free(candidates);
+    graph_grid_free(&grid);
+}
+
+int graph_rgg_connected(int vertices, double length, double width, double r, const double *x, const double *y)
+{
+    graph_grid grid;
+    graph_grid_init(&grid, vertices, length, width, r, x, y);
+
+    // The edges are symmetric, so a union-find over the pairs closer than
+    // 'r' gives the connected components in one pass. It stops at the
+    // first vertex without a neighbour:
+    int *parent = (int*)malloc((vertices > 0 ? vertices : 1) * sizeof(int));
+    int *candidates = (int*)malloc((vertices > 0 ? vertices : 1) * sizeof(int));
+    for (int i = 0; i < vertices; ++i)
+    {
+        parent[i] = i;
+    }
+    int components = vertices;
+    int connected = TRUE;
+    for (int i = 0; i < vertices && connected; ++i)
+    {
+        const int n = graph_grid_around(&grid, i, candidates);
+        int neighbours = 0;
+        for (int k = 0; k < n; ++k)
         {
-            group[head] = TRUE;
-            graph_test_cc(g, group, head);
+            const int j = candidates[k];
+            if (j == i || hypot(x[i] - x[j], y[i] - y[j]) >= r)
+            {
+                continue;
+            }
+            ++neighbours;
+            // Each pair is only joined once, from its first vertex:
+            if (j > i)
+            {
+                const int a = graph_find(parent, i);
+                const int b = graph_find(parent, j);
+                if (a != b)
+                {
+                    parent[b] = a;
+                    --components;
+                }
+            }
         }
+        connected = neighbours > 0 || vertices == 1;
+    }
+    free(parent);
+    free(candidates);
+    graph_grid_free(&grid);
+    return connected && components <= 1;
+}
+
+int graph_find(int *parent, int u)
+{
+    while (parent[u] != u)
+    {
+        parent[u] = parent[parent[u]]; // Path halving.
+        u = parent[u];
     }
+    return u;
 }
 
 // Grow the edge list of some vertex v.
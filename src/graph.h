@@ -1,9 +1,9 @@
 #ifndef GRAPH_H_
 #define GRAPH_H_
 
+#include <stdio.h>
 #include "common.h"
-#include <gsl/gsl_rng.h>
-#include <gsl/gsl_randist.h>
+#include "rng.h"
 
 /** A graph represented by an adjacency list (made of dynamic arrays). */
 typedef struct 
@@ -20,6 +20,24 @@ typedef struct
 }
 graph;
 
+/**
+ * A frozen graph in compressed sparse row form: the edges of all the
+ * vertices in three contiguous arrays, those of vertex 'u' from
+ * offset[u] to offset[u + 1] - 1, in the order of its adjacency list.
+ * Built once a graph is complete and read-only afterward.
+ */
+typedef struct
+{
+    int num_v; /** Number of vertices. */
+
+    int *offset; /** First edge of each vertex (num_v + 1 elements). */
+
+    int *target; /** Head of each edge. */
+
+    double *weight; /** Weight of each edge. */
+}
+graph_csr;
+
 /** Initialize a graph with a fixed number of vertices. */
 void graph_init(graph *g, int vertices);
 
@@ -56,7 +74,7 @@ int graph_rmv_sym_edges(graph *g, int u, int v);
 /** Return true if the graph has an edge between 'u' and 'v'. O(|E|). */
 int graph_has_edge(graph *g, int u, int v);
 
-/** Return true if the graph is strongly connected. */
+/** Return true if the graph is strongly connected. \f$O(|V| + |E|)\f$, without recursion. */
 int graph_strongly_connected(const graph *g);
 
 /** Print as a svg file (assumes all points are in the [0, 1) range).*/
@@ -77,6 +95,27 @@ void graph_print(const graph *g, FILE *out);
 /** Free the memory of the struct. */
 void graph_free(graph *g);
 
+/** Build the frozen form of a graph (the same edges, in the same order). \f$O(|V| + |E|)\f$. */
+void graph_csr_init(graph_csr *csr, const graph *g);
+
+/** Number of edges in the entire graph. \f$O(1)\f$. */
+int graph_csr_edges(const graph_csr *csr);
+
+/** Number of outgoing edges for vertex \f$v\f$. \f$O(1)\f$. */
+int graph_csr_outdegree(const graph_csr *csr, int u);
+
+/** Print as a svg file (assumes all points are in the [0, 1) range), see graph_svg. */
+void graph_csr_svg(const graph_csr *csr, double *x, double *y, double size, double offset, FILE *out);
+
+/** Print as a svg file with stronger colors for higher abundances, see graph_svg_abun. */
+void graph_csr_svg_abun(const graph_csr *csr, double *x, double *y, double size, double offset, double *abun, int color, FILE *out);
+
+/** Print the graph in GraphML format. */
+void graph_csr_graphml(const graph_csr *csr, FILE *out, unsigned int id);
+
+/** Free the memory of the struct. */
+void graph_csr_free(graph_csr *csr);
+
 /** 
  * Get a random geometric graph in [0,1]^2 with radius 'r'.
  * 
@@ -85,7 +124,7 @@ void graph_free(graph *g);
  * is the geometric distance between the two vertices (in short the 
  * weight is always between 0 and 1.0).
  */
-void graph_get_rgg(graph *g, int vertices, double r, double *x, double *y, gsl_rng *rng);
+void graph_get_rgg(graph *g, int vertices, double r, double *x, double *y, rng_stream *rng);
 
 /** 
  * Get a connected random geometric graph in [0,1]^2 with radius 'r'.
@@ -95,7 +134,7 @@ void graph_get_rgg(graph *g, int vertices, double r, double *x, double *y, gsl_r
  * is the geometric distance between the two vertices (in short the 
  * weight is always between 0 and 1.0).
  */
-void graph_get_crgg(graph *g, int vertices, double r, double *x, double *y, gsl_rng *rng);
+void graph_get_crgg(graph *g, int vertices, double r, double *x, double *y, rng_stream *rng);
 
 /**
  * Get a random geometric graph in a rectangle with an area of 1 and 
@@ -106,7 +145,7 @@ void graph_get_crgg(graph *g, int vertices, double r, double *x, double *y, gsl_
  * is the geometric distance between the two vertices (in short the 
  * weight is always between 0 and 1.0).
  */
-void graph_get_rec_rgg(graph *g, int vertices, double width, double r, double *x, double *y, gsl_rng *rng);
+void graph_get_rec_rgg(graph *g, int vertices, double width, double r, double *x, double *y, rng_stream *rng);
 
 /**
  * Get a connected random geometric graph in a rectangle with an area of
@@ -117,7 +156,7 @@ void graph_get_rec_rgg(graph *g, int vertices, double width, double r, double *x
  * is the geometric distance between the two vertices (in short the 
  * weight is always between 0 and 1.0).
  */
-void graph_get_rec_crgg(graph *g, int vertices, double width, double r, double *x, double *y, gsl_rng *rng);
+void graph_get_rec_crgg(graph *g, int vertices, double width, double r, double *x, double *y, rng_stream *rng);
 
 /**
  * Return a complete graph (all vertices linked to each other). Realized
@@ -139,8 +178,55 @@ void graph_get_star(graph *g, int vertices);
 ///////////////////////////////////////////////////////////////
 // 'Private' functions. You shouldn't need those.
 
-/** Recursive function used to test connectivity. */
-void graph_test_cc(const graph *g, int *group, int u);
+/**
+ * The vertices of a geometric graph bucketed in a grid of cells of side
+ * >= 'r', so the vertices closer than 'r' to a vertex are all in the 3x3
+ * cells around its own.
+ */
+typedef struct
+{
+    int mx; /** Number of cells along x. */
+
+    int my; /** Number of cells along y. */
+
+    int *cell; /** Cell of each vertex. */
+
+    int *start; /** Where the vertices of each cell start in 'items' (one more for the end). */
+
+    int *items; /** The vertices of each cell, in increasing order. */
+}
+graph_grid;
+
+/** Draw the points of a random geometric graph in a 'length' x 'width' rectangle. */
+void graph_rgg_points(int vertices, double length, double width, double *x, double *y, rng_stream *rng);
+
+/** Bucket the points in a grid for the radius 'r'. */
+void graph_grid_init(graph_grid *grid, int vertices, double length, double width, double r, const double *x, const double *y);
+
+/** Copy the vertices of the 3x3 cells around the vertex 'i' (itself included) in 'candidates' and return their number. */
+int graph_grid_around(const graph_grid *grid, int i, int *candidates);
+
+/** Free the memory of the grid. */
+void graph_grid_free(graph_grid *grid);
+
+/**
+ * Add the edges of a random geometric graph of radius 'r' between the
+ * vertices at 'x' and 'y' in a 'length' x 'width' rectangle. The points are
+ * bucketed in a grid of cells of side >= 'r', so only the pairs in adjacent
+ * cells are tested: the same edges, weights and order as testing all the
+ * pairs, in near-linear time instead of O(|V|^2).
+ */
+void graph_rgg_edges(graph *g, int vertices, double length, double width, double r, const double *x, const double *y);
+
+/**
+ * Return true if the random geometric graph of radius 'r' on these points
+ * is connected, without building it (union-find on the grid). Much cheaper
+ * than the graph, so the connected graphs reject the point sets first.
+ */
+int graph_rgg_connected(int vertices, double length, double width, double r, const double *x, const double *y);
+
+/** Root of the set of 'u' in a union-find (with path halving). */
+int graph_find(int *parent, int u);
 
 /** Increse the storage of the lists for vertex 'u'. O(|E|). */
 void graph_grow_lists(graph *g, int u);
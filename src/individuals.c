@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "common.h"
+#include "metacom.h"
+#include "individuals.h"
+
+void individuals_init(individuals *ind, const metacom *m, int j_per_c)
+{
+    assert(m->n_genotypes <= (1 << INDIVIDUALS_GENOTYPE_BITS));
+    ind->communities = m->communities;
+    ind->j_per_c = j_per_c;
+    ind->entries = (unsigned int*)malloc((size_t)m->communities * j_per_c * sizeof(unsigned int));
+
+    for (int c = 0; c < m->communities; ++c)
+    {
+        unsigned int *e = individuals_community(ind, c);
+        int i = 0;
+        for (int slot = 0; slot < m->end; ++slot)
+        {
+            const int *cell = metacom_cell(m, c, slot);
+            for (int g = 0; g < m->n_genotypes; ++g)
+            {
+                for (int n = 0; n < cell[1 + g]; ++n)
+                {
+                    e[i++] = individuals_entry(slot, g);
+                }
+            }
+        }
+        assert(i == j_per_c);
+    }
+}
+
+void individuals_relabel(individuals *ind, int c, int old_slot, int new_slot, int genotype)
+{
+    unsigned int *e = individuals_community(ind, c);
+    const unsigned int new_entry = individuals_entry(new_slot, genotype);
+    for (int i = 0; i < ind->j_per_c; ++i)
+    {
+        if (individuals_slot(e[i]) == old_slot)
+        {
+            e[i] = new_entry;
+        }
+    }
+}
+
+size_t individuals_memory(const individuals *ind)
+{
+    return (size_t)ind->communities * ind->j_per_c * sizeof(unsigned int);
+}
+
+void individuals_free(individuals *ind)
+{
+    free(ind->entries);
+    ind->entries = NULL;
+}
@@ -0,0 +1,50 @@
+#ifndef INDIVIDUALS_H_
+#define INDIVIDUALS_H_
+
+#include <stddef.h>
+#include "metacom.h"
+
+/** Number of bits used to store the genotype of an individual. */
+#define INDIVIDUALS_GENOTYPE_BITS    2
+
+/**
+ * The individuals of every community stored in flat arrays of packed
+ * (species slot, genotype) entries, so a random individual is a single
+ * array load. The order of the individuals within a community is
+ * meaningless. Slots are the slots of a metacom.
+ */
+typedef struct
+{
+    int communities; /** Number of communities. */
+
+    int j_per_c; /** Number of individuals per community. */
+
+    unsigned int *entries; /** 'j_per_c' entries per community (community-major). */
+}
+individuals;
+
+/** Pack a slot and a genotype into an entry. */
+#define individuals_entry(slot,genotype)    (((unsigned int)(slot) << INDIVIDUALS_GENOTYPE_BITS) | (unsigned int)(genotype))
+
+/** Return the species slot of an entry. */
+#define individuals_slot(e)                 ((int)((e) >> INDIVIDUALS_GENOTYPE_BITS))
+
+/** Return the genotype of an entry. */
+#define individuals_genotype(e)             ((int)((e) & ((1u << INDIVIDUALS_GENOTYPE_BITS) - 1)))
+
+/** Return a pointer to the entries of community 'c'. */
+#define individuals_community(ind,c)        ((ind)->entries + (size_t)(c) * (ind)->j_per_c)
+
+/** Initialize the arrays from the abundances and genotypes of a metacom (each community must have 'j_per_c' individuals). */
+void individuals_init(individuals *ind, const metacom *m, int j_per_c);
+
+/** Give the slot 'new_slot' and the genotype 'genotype' to all individuals of 'old_slot' in community 'c'. O(J). */
+void individuals_relabel(individuals *ind, int c, int old_slot, int new_slot, int genotype);
+
+/** Return the memory used by the entries (in bytes). */
+size_t individuals_memory(const individuals *ind);
+
+/** Free the memory. */
+void individuals_free(individuals *ind);
+
+#endif
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "common.h"
+#include "utils.h"
+#include "jobqueue.h"
+
+void job_queue_init(job_queue *q)
+{
+    q->capacity = VECTOR_INIT_CAPACITY;
+    q->jobs = (job*)malloc(q->capacity * sizeof(job));
+    q->order = NULL;
+    q->n_jobs = 0;
+    q->threads = 0;
+    q->next = 0;
+    q->f = NULL;
+    q->placement = NULL;
+    q->pinned = 0;
+    q->seconds = 0.0;
+    pthread_mutex_init(&q->lock, NULL);
+}
+
+int job_queue_add(job_queue *q, void *data, double cost)
+{
+    if (q->n_jobs == q->capacity)
+    {
+        q->capacity *= VECTOR_GROW_RATE;
+        q->jobs = (job*)realloc(q->jobs, q->capacity * sizeof(job));
+    }
+    job *j = &q->jobs[q->n_jobs];
+    j->id = q->n_jobs;
+    j->cost = cost;
+    j->data = data;
+    j->thread = -1;
+    j->seconds = 0.0;
+    return q->n_jobs++;
+}
+
+void job_queue_set_affinity(job_queue *q, const affinity *placement)
+{
+    q->placement = placement;
+}
+
+void job_queue_run(job_queue *q, int threads, void *(*f)(void*))
+{
+    if (threads > q->n_jobs)
+    {
+        threads = q->n_jobs;
+    }
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+    // Longest expected jobs first:
+    q->order = (job**)realloc(q->order, q->n_jobs * sizeof(job*));
+    for (int i = 0; i < q->n_jobs; ++i)
+    {
+        q->order[i] = &q->jobs[i];
+    }
+    qsort(q->order, q->n_jobs, sizeof(job*), job_queue_compare);
+    q->threads = threads;
+    q->next = 0;
+    q->pinned = 0;
+    q->f = f;
+
+    const double start = seconds_monotonic();
+    pthread_t *ids = (pthread_t*)malloc(threads * sizeof(pthread_t));
+    job_queue_thread_arg *args = (job_queue_thread_arg*)malloc(threads * sizeof(job_queue_thread_arg));
+    for (int t = 0; t < threads; ++t)
+    {
+        args[t].q = q;
+        args[t].id = t;
+        pthread_create(&ids[t], NULL, job_queue_thread, (void*)&args[t]);
+    }
+    for (int t = 0; t < threads; ++t)
+    {
+        pthread_join(ids[t], NULL);
+    }
+    q->seconds = seconds_monotonic() - start;
+    free(ids);
+    free(args);
+}
+
+void job_queue_print(const job_queue *q, FILE *out)
+{
+    double busy = 0.0;
+    for (int i = 0; i < q->n_jobs; ++i)
+    {
+        busy += q->jobs[i].seconds;
+    }
+    fprintf(out, "  <jobs>\n");
+    fprintf(out, "    <threads>%d</threads>\n", q->threads);
+    fprintf(out, "    <wall_seconds>%.3f</wall_seconds>\n", q->seconds);
+    fprintf(out, "    <busy_seconds>%.3f</busy_seconds>\n", busy);
+    if (q->placement != NULL)
+    {
+        fprintf(out, "    <pinned_threads>%d</pinned_threads>\n", q->pinned);
+    }
+    for (int i = 0; i < q->n_jobs; ++i)
+    {
+        const job *j = &q->jobs[i];
+        fprintf(out, "    <job>\n");
+        fprintf(out, "      <id>%d</id>\n", j->id);
+        fprintf(out, "      <thread>%d</thread>\n", j->thread);
+        fprintf(out, "      <seconds>%.3f</seconds>\n", j->seconds);
+        fprintf(out, "    </job>\n");
+    }
+    fprintf(out, "  </jobs>\n");
+}
+
+void job_queue_free(job_queue *q)
+{
+    free(q->jobs);
+    free(q->order);
+    pthread_mutex_destroy(&q->lock);
+}
+
+int job_queue_processors()
+{
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n < 1 ? 1 : (int)n;
+}
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions
+
+void *job_queue_thread(void *arg)
+{
+    job_queue *q = ((job_queue_thread_arg*)arg)->q;
+    const int id = ((job_queue_thread_arg*)arg)->id;
+    // Pinned before the first job, so the simulations allocate on the node of the thread:
+    if (q->placement != NULL && affinity_pin(q->placement, id))
+    {
+        pthread_mutex_lock(&q->lock);
+        ++q->pinned;
+        pthread_mutex_unlock(&q->lock);
+    }
+    while (true)
+    {
+        pthread_mutex_lock(&q->lock);
+        const int i = q->next < q->n_jobs ? q->next++ : -1;
+        pthread_mutex_unlock(&q->lock);
+        if (i == -1)
+        {
+            return NULL;
+        }
+        job *j = q->order[i];
+        const double start = seconds_monotonic();
+        q->f(j->data);
+        j->seconds = seconds_monotonic() - start;
+        j->thread = id;
+    }
+}
+
+int job_queue_compare(const void *a, const void *b)
+{
+    const job *x = *(job* const*)a;
+    const job *y = *(job* const*)b;
+    if (x->cost != y->cost)
+    {
+        return x->cost > y->cost ? -1 : 1;
+    }
+    return x->id - y->id;
+}
@@ -0,0 +1,95 @@
+#ifndef JOBQUEUE_H_
+#define JOBQUEUE_H_
+
+#include <stdio.h>
+#include <pthread.h>
+#include "affinity.h"
+
+/** A job: one call of the function of the queue on 'data'. */
+typedef struct
+{
+    int id; /** Index of the job, in the order of the calls to job_queue_add. */
+
+    double cost; /** Expected cost (only the order of the costs matters). */
+
+    void *data; /** Argument of the function. */
+
+    int thread; /** Thread that ran the job. */
+
+    double seconds; /** Wall time of the job. */
+}
+job;
+
+/**
+ * A fixed number of threads running a list of jobs. The jobs are sorted
+ * by decreasing expected cost (the longest first, then in the order they
+ * were added) and every thread takes the next job as soon as it is done
+ * with the previous one, so the threads stay busy even when the actual
+ * costs differ a lot from the expected ones.
+ */
+typedef struct
+{
+    job *jobs; /** The jobs, in the order of their ids. */
+
+    job **order; /** The jobs in the order they are started (set by job_queue_run). */
+
+    int n_jobs; /** Number of jobs. */
+
+    int capacity; /** Capacity of 'jobs'. */
+
+    int threads; /** Number of threads used by the last run. */
+
+    int next; /** Next job to start. */
+
+    pthread_mutex_t lock; /** Protects 'next'. */
+
+    void *(*f)(void*); /** The function called for each job. */
+
+    const affinity *placement; /** Where to pin the threads (NULL to leave them free). */
+
+    int pinned; /** Number of threads pinned by the last run. */
+
+    double seconds; /** Wall time of the last run. */
+}
+job_queue;
+
+/** Initialize an empty queue. */
+void job_queue_init(job_queue *q);
+
+/** Add a job and return its id. */
+int job_queue_add(job_queue *q, void *data, double cost);
+
+/** Pin the threads of the next runs following 'placement' (the 'i'th thread created gets the 'i'th place). */
+void job_queue_set_affinity(job_queue *q, const affinity *placement);
+
+/** Run all the jobs with 'f' on at most 'threads' threads and return once they are all done. */
+void job_queue_run(job_queue *q, int threads, void *(*f)(void*));
+
+/** Print the number of threads and the thread and wall time of each job, in the order of the ids. */
+void job_queue_print(const job_queue *q, FILE *out);
+
+/** Free the memory. */
+void job_queue_free(job_queue *q);
+
+/** Number of processors online (at least 1). */
+int job_queue_processors();
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions. You shouldn't need those.
+
+/** Main function of the threads ('arg' points to a job_queue_thread_arg). */
+void *job_queue_thread(void *arg);
+
+/** Argument of the threads. */
+typedef struct
+{
+    job_queue *q;
+
+    int id;
+}
+job_queue_thread_arg;
+
+/** Order of the jobs (pointers to job): decreasing cost, then increasing id. */
+int job_queue_compare(const void *a, const void *b);
+
+#endif
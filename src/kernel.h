@@ -0,0 +1,52 @@
+#ifndef KERNEL_H_
+#define KERNEL_H_
+
+#include "common.h"
+#include "rng.h"
+
+#define MODEL_BDM_NEUTRAL      0
+#define MODEL_BDM_SELECTION    1
+
+/** Name of the event kernel of a model (for the output). */
+#define kernel_name(model)    ((model) == MODEL_BDM_NEUTRAL ? "neutral" : "selection")
+
+/**
+ * Return the genotype (0 = aa, 1 = Ab, 2 = AB) of the parent of a local
+ * replacement, given a uniform deviate 'r' and the genotypes of the
+ * parent's species in the community. Genotypes are picked in proportion to
+ * their fitness: 1 for aa, 1 + s for Ab and (1 + s)^2 for AB.
+ *
+ * 'model' must be a constant: the engines call it from loops specialised
+ * per model, so the neutral kernel compiles to comparisons of counts with
+ * none of the fitness arithmetic.
+ */
+ORIGIN_FORCE_INLINE int kernel_genotype(const int model, double r, int aa, int Ab, int AB, double s)
+{
+    if (model == MODEL_BDM_NEUTRAL)
+    {
+        // Without selection the fitness of a genotype is its count:
+        const double x = r * (aa + Ab + AB);
+        if (x < aa)
+        {
+            return 0;
+        }
+        return (AB == 0 || x < aa + Ab) ? 1 : 2;
+    }
+    // The total fitness of the population 'W':
+    const double w = aa + Ab * (1.0 + s) + AB * (1.0 + s) * (1.0 + s);
+
+    if (r < aa / w)
+    {
+        return 0;
+    }
+    return (AB == 0 || r < (aa + Ab * (1.0 + s)) / w) ? 1 : 2;
+}
+
+/** Return the genotype of the offspring of a local replacement: the genotype of the parent, mutated with probability 'mu' (aa to Ab, Ab to AB). */
+ORIGIN_FORCE_INLINE int kernel_offspring(const int model, rng_stream *rs, int aa, int Ab, int AB, double s, double mu)
+{
+    const int g = kernel_genotype(model, rng_stream_uniform(rs), aa, Ab, AB, s);
+    return (g < 2 && rng_stream_uniform(rs) < mu) ? g + 1 : g;
+}
+
+#endif
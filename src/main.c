@@ -4,19 +4,37 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #include <pthread.h>
 #include <assert.h>
-#include <gsl/gsl_rng.h>
-#include <gsl/gsl_randist.h>
 #include "common.h"
+#include "rng.h"
 #include "ivector.h"
 #include "species.h"
 #include "specieslist.h"
+#include "speciesindex.h"
 #include "graph.h"
+#include "migration.h"
+#include "metacom.h"
+#include "individuals.h"
+#include "parallel.h"
+#include "coalescent.h"
+#include "speciespool.h"
+#include "kernel.h"
+#include "forward.h"
+#include "jobqueue.h"
+#include "sweep.h"
+#include "affinity.h"
+#include "checkpoint.h"
+#include "convergence.h"
+#include "results.h"
+#include "writer.h"
+#include "ensemble.h"
+#include "runlog.h"
 #include "utils.h"
 
-#define MODEL_BDM_NEUTRAL      0
-#define MODEL_BDM_SELECTION    1
+#define ENGINE_FORWARD         0
+#define ENGINE_COALESCENT      1
 
 // Parameters of the simulations.
 typedef struct
@@ -31,6 +49,29 @@ typedef struct
     double s;          // Selection coefficient.
     double r;          // Radius (for random geometric graphs).
     double w;          // Width (for rectangle random geometric graphs).
+    int sampler;       // Method used to pick individuals in a community.
+    int migration;     // Method used to pick the community of origin.
+    int state;         // Storage of the abundances and genotypes.
+    int rng;           // Backend of the random number generator.
+    int engine;        // Forward simulation or backward coalescent.
+    bool skip;         // Geometric skip-ahead for migrations and mutations.
+    int workers;       // Threads per simulation (0 = sequential engines).
+    int sync;          // Time steps between synchronisations (0 = per generation).
+    int checkpoint;    // Groups of 1000 generations between two checkpoints (0 = none).
+    char *resume;      // Checkpoint to resume from (NULL = none).
+    int burnin;        // Generations (in thousands) of the burn-in shared by the replicates (0 = none).
+    bool burning;      // True for the burn-in itself.
+    checkpoint *snapshot; // State at the end of the burn-in (written by the burn-in, read by the replicates).
+    int converge;      // Groups of 1000 generations the series must be stationary over to stop (0 = never).
+    double tolerance;  // Largest relative change of the series accepted as stationary.
+    int format;        // Format of the output of the simulations (RESULTS_XML or RESULTS_BINARY).
+    writer *output;    // The thread writing the files (NULL = written by the simulations).
+    bool files;        // True to write the files of each simulation.
+    ensemble *summary; // Where the replicates fold their statistics (NULL = no ensemble).
+    runlog *log;       // Log of the progress (NULL = none).
+    unsigned int seed; // Seed of the generator (0 = /dev/urandom).
+    int replicate;     // Index of the simulation.
+    int point;         // Index of the parameter point of a sweep (-1 without a sweep).
     char *ofilename;   // Name of the output files.
     char *shape;       // Shape of the metacommunity.
 }
@@ -39,7 +80,23 @@ Params;
 // Prototype for the function used by the threads
 void *sim(void *parameters);
 // The function used to setup the cumulative jagged array from the graph.
-double **setup_cumulative_list(const graph *g, double omega);
+double **setup_cumulative_list(const graph_csr *g, double omega);
+// Name of a state backend (for the output).
+const char *state_name(int state);
+// How new species are founded by an engine (for the output).
+const char *speciation_rule(int engine);
+// Expected cost of a simulation (to run the longest first).
+double expected_cost(const Params *P);
+// Read the parameters of the simulations from options of the form -name=value.
+void read_params(Params *p, const char *argv[], int argc);
+// Name of an output file of a simulation, ending with 'suffix'.
+void output_filename(const Params *P, const char *suffix, char *buffer);
+// Append the parameters, the seed, the first group of 1000 generations simulated by the replicate and the number done to a checkpoint.
+void write_checkpoint_header(checkpoint *ck, const Params *P, unsigned int seed, int k_first, int k_done);
+// Read the header of a checkpoint, return false if it doesn't match the parameters.
+bool read_checkpoint_header(checkpoint *ck, const Params *P, unsigned int *seed, int *k_first, int *k_done);
+// Print the index of the results of a sweep.
+void print_sweep_index(const sweep *sw, const Params *sim_p, const job_queue *jobs, FILE *out);
 
 /////////////////////////////////////////////////////////////
 // Main                                                    //
@@ -58,11 +115,45 @@ int main(int argc, const char *argv[])
     p.s = 0.15;
     p.r = 0.25;
     p.w = 0.25;
+    p.sampler = SAMPLER_FENWICK;
+    p.migration = MIGRATION_ALIAS;
+    p.state = STATE_LIST;
+    p.rng = RNG_XOSHIRO;
+    p.engine = ENGINE_FORWARD;
+    p.skip = false;
+    p.workers = 0;
+    p.sync = 0;
+    p.checkpoint = 0;
+    p.resume = NULL;
+    p.burnin = 0;
+    p.burning = false;
+    p.snapshot = NULL;
+    p.converge = 0;
+    p.tolerance = 0.1;
+    p.format = RESULTS_XML;
+    p.output = NULL;
+    p.files = true;
+    p.summary = NULL;
+    p.log = NULL;
+    p.seed = 0;
+    p.replicate = 0;
+    p.point = -1;
     p.ofilename = (char*)malloc(50);
     p.shape = (char*)malloc(20);
 
     // Number of simulations;
-    int n_threads = 1;
+    int n_sims = 1;
+    // Number of threads running the simulations (0 = one per processor):
+    int n_threads = 0;
+    // Placement of the threads:
+    int placement = AFFINITY_NONE;
+    // Buffers waiting for the thread writing the files (0 = no thread):
+    int queue = 16;
+    // Summary of the replicates of each point, and the files of each simulation:
+    int summarize = 0;
+    int files = -1;
+    // Log of the progress of the simulations:
+    char *log_file = (char*)malloc(SWEEP_LINE_LENGTH);
 
     // Options;
     if (argc > 1 && argv[1][0] == '-' && argv[1][1] == '-')
@@ -78,10 +169,65 @@ int main(int argc, const char *argv[])
             printf("  --ref           Display reference.\n");
             printf("Simulation parameters:\n");
             printf("  -x\n");
-            printf("    description:  Number of simulations to run. Each simulation\n");
-            printf("                  will use a distinct POSIX thread. \n");
+            printf("    description:  Number of simulations to run.\n");
             printf("    values:       Any unsigned integer.\n");
             printf("    default:      1\n");
+            printf("  -affinity\n");
+            printf("    description:  Pin the threads running the simulations (Linux).\n");
+            printf("                  Each simulation allocates its state from its\n");
+            printf("                  thread, so on the node of the thread. With\n");
+            printf("                  -workers the threads are pinned to a node.\n");
+            printf("    values:       0, 1, 2.\n");
+            printf("    details:      0 = Not pinned.\n");
+            printf("                  1 = Compact, the nodes are filled one by one.\n");
+            printf("                  2 = Round-robin over the nodes.\n");
+            printf("    default:      0\n");
+            printf("  -writer\n");
+            printf("    description:  Size of the queue of the thread writing the\n");
+            printf("                  files, so the simulations don't wait for the\n");
+            printf("                  disk (they only wait when the queue is full).\n");
+            printf("    values:       Any unsigned integer (0 = no thread, the\n");
+            printf("                  simulations write their own files).\n");
+            printf("    default:      16\n");
+            printf("  -ensemble\n");
+            printf("    description:  Summarize the -x replicates (of each point of a\n");
+            printf("                  sweep) in [o]ensemble.xml ([o][point]-ensemble.xml\n");
+            printf("                  with a sweep): mean, variance and quantiles of the\n");
+            printf("                  series per 1000 generations, of the abundances by\n");
+            printf("                  rank, and of the octaves.\n");
+            printf("    values:       0 (no summary), 1.\n");
+            printf("    default:      0\n");
+            printf("  -files\n");
+            printf("    description:  Write the files of each simulation (XML or binary,\n");
+            printf("                  GraphML and SVG).\n");
+            printf("    values:       0, 1.\n");
+            printf("    default:      1, or 0 with -ensemble=1.\n");
+            printf("  -log\n");
+            printf("    description:  Log of the run, one line per event written as\n");
+            printf("                  it happens (- for the standard error): start\n");
+            printf("                  and end of each simulation and, every 1000\n");
+            printf("                  generations, its progress (generations done,\n");
+            printf("                  events per second, species, seconds left).\n");
+            printf("    values:       A file name, or -.\n");
+            printf("    default:      No log.\n");
+            printf("  -sweep\n");
+            printf("    description:  Grid of parameters, one line per parameter\n");
+            printf("                  with its values or ranges from:to:step\n");
+            printf("                  (e.g.: \"mu 1e-5 1e-4\", \"omega 1e-4:1e-3:3e-4\").\n");
+            printf("                  The -x simulations are run for every combination\n");
+            printf("                  and indexed in [o]sweep.xml.\n");
+            printf("    values:       Name of a file.\n");
+            printf("  -jobs\n");
+            printf("    description:  Like -sweep, but one parameter point per line\n");
+            printf("                  written like the command line (e.g.: \"-mu=1e-4\n");
+            printf("                  -shape=star\").\n");
+            printf("    values:       Name of a file.\n");
+            printf("  -threads\n");
+            printf("    description:  Number of POSIX threads running the simulations.\n");
+            printf("                  Each thread takes the next simulation as soon as\n");
+            printf("                  it is done with the previous one.\n");
+            printf("    values:       Any unsigned integer (0 = one per processor).\n");
+            printf("    default:      0\n");
             printf("  -model\n");
             printf("    description:  Set the model used.\n");
             printf("    values:       0, 1.\n");
@@ -131,6 +277,120 @@ int main(int argc, const char *argv[])
             printf("    description:  The weight of the proper edges.\n");
             printf("    values:       Any nonnegative double.\n");
             printf("    default:      5e-4\n");
+            printf("  -sampler\n");
+            printf("    description:  Method used to pick individuals in a community.\n");
+            printf("    values:       0, 1.\n");
+            printf("    details:      0 = Walk the list of species, O(S).\n");
+            printf("                  1 = Fenwick tree of abundances, O(log S).\n");
+            printf("                  Both give the same results for the same seed.\n");
+            printf("    default:      1\n");
+            printf("  -migration\n");
+            printf("    description:  Method used to pick the community of origin\n");
+            printf("                  of a new individual.\n");
+            printf("    values:       0, 1.\n");
+            printf("    details:      0 = Scan a cumulative list, O(degree).\n");
+            printf("                  1 = Walker/Vose alias table, O(1).\n");
+            printf("    default:      1\n");
+            printf("  -state\n");
+            printf("    description:  Storage of the abundances and genotypes.\n");
+            printf("    values:       0, 1, 2.\n");
+            printf("    details:      0 = A list of species, each with its own arrays.\n");
+            printf("                  1 = One dense block, community-major.\n");
+            printf("                  2 = Arrays of individuals over a dense block,\n");
+            printf("                      O(1) per draw (-sampler is ignored).\n");
+            printf("    default:      0\n");
+            printf("  -rng\n");
+            printf("    description:  Random number generator.\n");
+            printf("    values:       0, 1, 2.\n");
+            printf("    details:      0 = GSL's taus2 (same numbers as older versions).\n");
+            printf("                  1 = xoshiro256++, generated in blocks.\n");
+            printf("                  2 = Philox4x32-10, counter-based, one substream\n");
+            printf("                      per community keyed by the seed and the\n");
+            printf("                      index of the simulation.\n");
+            printf("    default:      1\n");
+            printf("  -skip\n");
+            printf("    description:  Draw the number of replacements until the next\n");
+            printf("                  migration and the next mutation of each community\n");
+            printf("                  from geometric distributions instead of drawing\n");
+            printf("                  a number for each event. Same process, different\n");
+            printf("                  numbers. Ignored with -workers.\n");
+            printf("    values:       0, 1.\n");
+            printf("    default:      0\n");
+            printf("  -engine\n");
+            printf("    description:  How the final metacommunity is obtained.\n");
+            printf("    values:       0, 1.\n");
+            printf("    details:      0 = Forward simulation of every replacement.\n");
+            printf("                  1 = Backward spatial coalescent of the final\n");
+            printf("                      individuals, only with -model=0. Gives the\n");
+            printf("                      distributions and octaves, but not the\n");
+            printf("                      extinctions, lifespans and sizes at speciation.\n");
+            printf("                      A new species is founded by any lineage that\n");
+            printf("                      becomes AB, not by a whole local population:\n");
+            printf("                      its distributions can't be compared with those\n");
+            printf("                      of forward runs (see <speciation_rule>).\n");
+            printf("    default:      0\n");
+            printf("  -workers\n");
+            printf("    description:  Number of threads per simulation. The communities\n");
+            printf("                  are split between the threads and migrants are\n");
+            printf("                  drawn from the state at the last synchronisation.\n");
+            printf("                  Forces -rng=2 and -migration=1, -state is ignored.\n");
+            printf("    values:       Any unsigned integer (0 = one thread, no delay).\n");
+            printf("    default:      0\n");
+            printf("  -sync\n");
+            printf("    description:  Number of time steps between two synchronisations\n");
+            printf("                  of the threads (with -workers).\n");
+            printf("    values:       Any unsigned integer (0 = once per generation).\n");
+            printf("    default:      0\n");
+            printf("  -checkpoint\n");
+            printf("    description:  Save the state of the simulation every N groups\n");
+            printf("                  of 1000 generations in [o][seed].ckpt (written\n");
+            printf("                  in the background, the file is replaced at once).\n");
+            printf("                  Only for the sequential forward engine.\n");
+            printf("    values:       Any unsigned integer (0 = no checkpoints).\n");
+            printf("    default:      0\n");
+            printf("  -resume\n");
+            printf("    description:  Continue the simulation saved in a checkpoint,\n");
+            printf("                  with the same results as if it had not stopped.\n");
+            printf("                  The other options must be the same as when it\n");
+            printf("                  was written (the seed comes from the checkpoint).\n");
+            printf("    values:       Name of a checkpoint.\n");
+            printf("  -burnin\n");
+            printf("    description:  Run the first N thousand generations once (per\n");
+            printf("                  point of a sweep), then start the -x simulations\n");
+            printf("                  from its final state with their own seeds. The\n");
+            printf("                  burn-in is saved as [o]burnin-[seed].xml.\n");
+            printf("                  Only for the sequential forward engine.\n");
+            printf("    values:       Any unsigned integer smaller than -g (0 = none).\n");
+            printf("    default:      0\n");
+            printf("  -converge\n");
+            printf("    description:  Stop a simulation once the number of species,\n");
+            printf("                  speciation and extinction events per 1000\n");
+            printf("                  generations are stationary over the last N\n");
+            printf("                  groups of 1000 generations (the means of the\n");
+            printf("                  two halves differ by at most -tolerance). Not\n");
+            printf("                  for the coalescent.\n");
+            printf("    values:       Any unsigned integer (0 = run all -g).\n");
+            printf("    default:      0\n");
+            printf("  -tolerance\n");
+            printf("    description:  Largest relative change accepted by -converge.\n");
+            printf("    values:       Any positive real.\n");
+            printf("    default:      0.1\n");
+            printf("  -format\n");
+            printf("    description:  Format of the output of the simulations. The\n");
+            printf("                  binary files ([o][seed].bin) are smaller, faster\n");
+            printf("                  to read, and hold the series per 1000 generations\n");
+            printf("                  as soon as they are known (forward engine). Use\n");
+            printf("                  -convert to get the XML.\n");
+            printf("    values:       0 (XML), 1 (binary).\n");
+            printf("    default:      0\n");
+            printf("  -convert\n");
+            printf("    description:  Print the XML of a binary output and exit.\n");
+            printf("    values:       Name of a binary output.\n");
+            printf("  -seed\n");
+            printf("    description:  Seed of the first simulation, the next ones\n");
+            printf("                  use seed + 1, seed + 2, ...\n");
+            printf("    values:       Any positive integer (0 = /dev/urandom).\n");
+            printf("    default:      0\n");
             printf("  -o\n");
             printf("    description:  Name of the output files.\n");
             printf("    values:       Any string.\n");
@@ -150,31 +410,78 @@ int main(int argc, const char *argv[])
         }
     } // end '--' options
 
+    // Convert a binary output to XML:
+    char *convert = (char*)malloc(SWEEP_LINE_LENGTH);
+    if (read_opt_s("convert", argv, argc, convert))
+    {
+        const bool converted = results_to_xml(convert, stdout);
+        if (!converted)
+        {
+            fprintf(stderr, "%s is missing, invalid, or cut short.\n", convert);
+        }
+        free(convert);
+        return converted ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    free(convert);
+
     // Read options
-    read_opt_i("g", argv, argc, &p.k_gen);
-    read_opt_i("jpc", argv, argc, &p.j_per_c);
-    read_opt_i("model", argv, argc, &p.m);
-    read_opt_i("c", argv, argc, &p.communities);
-    read_opt_i("sp", argv, argc, &p.init_species);
-    read_opt_i("x", argv, argc, &n_threads);
-    read_opt_d("mu", argv, argc, &p.mu);
-    read_opt_d("omega", argv, argc, &p.omega);
-    read_opt_d("r", argv, argc, &p.r);
-    read_opt_d("w", argv, argc, &p.w);
-    read_opt_d("s", argv, argc, &p.s);
+    sprintf(p.shape, "random");
+    const Params defaults = p;
+    read_params(&p, argv, argc);
+    read_opt_i("x", argv, argc, &n_sims);
+    read_opt_i("threads", argv, argc, &n_threads);
+    read_opt_i("affinity", argv, argc, &placement);
+    read_opt_i("writer", argv, argc, &queue);
+    read_opt_i("ensemble", argv, argc, &summarize);
+    read_opt_i("files", argv, argc, &files);
+    const bool logging = read_opt_s("log", argv, argc, log_file);
+    if (files < 0)
+    {
+        // Only the summary by default:
+        files = summarize ? 0 : 1;
+    }
+    if (n_threads <= 0)
+    {
+        n_threads = job_queue_processors();
+    }
     if (read_opt_s("o", argv, argc, p.ofilename) == false)
     {
         sprintf(p.ofilename, "");
     }
-    if (read_opt_s("shape", argv, argc, p.shape) == false)
+    char *resume = (char*)malloc(SWEEP_LINE_LENGTH);
+    if (read_opt_s("resume", argv, argc, resume))
+    {
+        p.resume = resume;
+    }
+    // The parameter points of a sweep:
+    sweep sw;
+    sweep_init(&sw);
+    char *sweep_file = (char*)malloc(SWEEP_LINE_LENGTH);
+    if (read_opt_s("sweep", argv, argc, sweep_file) && !sweep_read_grid(&sw, sweep_file))
+    {
+        fprintf(stderr, "Can't read the grid %s.\n", sweep_file);
+        return EXIT_FAILURE;
+    }
+    if (read_opt_s("jobs", argv, argc, sweep_file) && !sweep_read_jobs(&sw, sweep_file))
+    {
+        fprintf(stderr, "Can't read the jobs %s.\n", sweep_file);
+        return EXIT_FAILURE;
+    }
+    free(sweep_file);
+    if (p.resume != NULL && (sw.n_points > 0 || n_sims != 1 || p.workers > 0 || p.engine != ENGINE_FORWARD || p.burnin > 0))
     {
-        sprintf(p.shape, "random");
+        fprintf(stderr, "-resume continues one simulation of the sequential forward engine (no -x, -sweep, -jobs, -workers or -burnin).\n");
+        return EXIT_FAILURE;
     }
 
     printf("<?xml version=\"1.0\"?>\n");
     printf("<origin_ssne>\n");
     printf("  <model>");
-    if (p.m == MODEL_BDM_NEUTRAL)
+    if (p.m == MODEL_BDM_NEUTRAL && p.engine == ENGINE_COALESCENT)
+    {
+        printf("Neutral lineage speciation</model>\n");
+    }
+    else if (p.m == MODEL_BDM_NEUTRAL)
     {
         printf("Neutral BDM speciation</model>\n");
     }
@@ -182,7 +489,8 @@ int main(int argc, const char *argv[])
     {
         printf("BDM speciation with selection</model>\n");
     }
-    printf("  <n>%d</n>\n", n_threads);
+    printf("  <speciation_rule>%s</speciation_rule>\n", speciation_rule(p.engine));
+    printf("  <n>%d</n>\n", n_sims);
     printf("  <shape_metacom>%s</shape_metacom>\n", p.shape);
     printf("  <metacom_size>%d</metacom_size>\n", p.j_per_c * p.communities);
     printf("  <k_gen>%d</k_gen>\n", p.k_gen);
@@ -203,25 +511,247 @@ int main(int argc, const char *argv[])
     {
         printf("  <width>%.4f</width>\n", p.w);
     }
+    printf("  <engine>%s</engine>\n", p.engine == ENGINE_COALESCENT ? "Coalescent" : "Forward");
+    printf("  <sampler>%s</sampler>\n", p.sampler == SAMPLER_FENWICK ? "Fenwick tree" : "Linear walk");
+    printf("  <migration>%s</migration>\n", p.migration == MIGRATION_ALIAS ? "Alias table" : "Cumulative list");
+    if (p.workers > 0)
+    {
+        printf("  <workers>%d</workers>\n", p.workers);
+        printf("  <sync_interval>%d</sync_interval>\n", p.sync);
+    }
+    else
+    {
+        printf("  <state>%s</state>\n", state_name(p.state));
+    }
+    printf("  <rng>%s</rng>\n", p.rng == RNG_GSL ? "GSL taus2" : (p.rng == RNG_PHILOX ? "Philox4x32-10" : "xoshiro256++"));
+    if (p.state == STATE_INDIVIDUALS)
+    {
+        printf("  <individuals_memory>%lu</individuals_memory>\n", (unsigned long)p.communities * p.j_per_c * sizeof(unsigned int));
+    }
+    if (p.converge > 0)
+    {
+        printf("  <converge>%d</converge>\n", p.converge);
+        printf("  <tolerance>%.4f</tolerance>\n", p.tolerance);
+    }
     printf("  <filename>%s</filename>\n", p.ofilename);
+    if (sw.n_points > 0)
+    {
+        printf("  <sweep_points>%d</sweep_points>\n", sw.n_points);
+        printf("  <sweep_index>%ssweep.xml</sweep_index>\n", p.ofilename);
+    }
 
-    // The threads:
-    pthread_t threads[n_threads];
+    // The parameter points, the options of a point coming before (and
+    // thus overriding) those of the command line:
+    const int n_points = sw.n_points > 0 ? sw.n_points : 1;
+    Params *points = (Params*)malloc(n_points * sizeof(Params));
+    points[0] = p;
+    for (int pt = 0; pt < sw.n_points; ++pt)
+    {
+        const int n_args = 1 + sw.n_options[pt] + (argc - 1);
+        const char **args = (const char**)malloc(n_args * sizeof(char*));
+        args[0] = argv[0];
+        for (int i = 0; i < sw.n_options[pt]; ++i)
+        {
+            args[1 + i] = sw.options[pt][i];
+        }
+        for (int i = 1; i < argc; ++i)
+        {
+            args[sw.n_options[pt] + i] = argv[i];
+        }
+        points[pt] = defaults;
+        points[pt].shape = (char*)malloc(20);
+        sprintf(points[pt].shape, "random");
+        read_params(&points[pt], args, n_args);
+        points[pt].point = pt;
+        free(args);
+    }
 
     const time_t start = time(NULL);
 
-    // Create the threads:
-    for (int i = 0; i < n_threads; ++i)
+    runlog run_log;
+    if (!runlog_open(&run_log, logging ? log_file : NULL, n_points * n_sims, n_threads))
+    {
+        fprintf(stderr, "Can't open the log %s.\n", log_file);
+    }
+    free(log_file);
+
+    // The files of all the simulations are written by one thread:
+    writer output;
+    if (queue > 0)
+    {
+        writer_init(&output, queue);
+    }
+    ensemble *ensembles = summarize ? (ensemble*)malloc(n_points * sizeof(ensemble)) : NULL;
+    for (int pt = 0; pt < n_points; ++pt)
+    {
+        points[pt].output = queue > 0 ? &output : NULL;
+        points[pt].files = files != 0;
+        points[pt].log = &run_log;
+        if (ensembles != NULL)
+        {
+            ensemble_init(&ensembles[pt], n_sims);
+            points[pt].summary = &ensembles[pt];
+        }
+    }
+
+    // The burn-in of each point, run first, leaves its state in a snapshot
+    // the replicates of the point start from:
+    checkpoint *snapshots = NULL;
+    Params *burnin_p = NULL;
+    for (int pt = 0; pt < n_points; ++pt)
+    {
+        if (points[pt].burnin > 0 && (points[pt].burnin >= points[pt].k_gen || points[pt].workers > 0 || points[pt].engine != ENGINE_FORWARD))
+        {
+            fprintf(stderr, "-burnin must be shorter than -g, for the sequential forward engine. Ignored.\n");
+            points[pt].burnin = 0;
+        }
+        if (points[pt].converge > 0 && points[pt].engine == ENGINE_COALESCENT)
+        {
+            fprintf(stderr, "-converge needs the forward engine. Ignored.\n");
+            points[pt].converge = 0;
+        }
+        if (points[pt].burnin > 0 && snapshots == NULL)
+        {
+            snapshots = (checkpoint*)malloc(n_points * sizeof(checkpoint));
+            burnin_p = (Params*)malloc(n_points * sizeof(Params));
+        }
+    }
+    if (snapshots != NULL)
+    {
+        job_queue burnins;
+        job_queue_init(&burnins);
+        for (int pt = 0; pt < n_points; ++pt)
+        {
+            checkpoint_init(&snapshots[pt], NULL);
+            if (points[pt].burnin == 0)
+            {
+                continue;
+            }
+            Params *q = &burnin_p[pt];
+            *q = points[pt];
+            q->k_gen = points[pt].burnin;
+            q->burning = true;
+            q->snapshot = &snapshots[pt];
+            // The seed after those of the replicates:
+            if (points[pt].seed != 0)
+            {
+                q->seed = points[pt].seed + n_sims;
+            }
+            points[pt].snapshot = &snapshots[pt];
+            job_queue_add(&burnins, (void*)q, expected_cost(q));
+        }
+        job_queue_run(&burnins, n_threads, sim);
+        for (int pt = 0; pt < n_points; ++pt)
+        {
+            if (points[pt].burnin > 0)
+            {
+                printf("  <burnin_seed>%u</burnin_seed>\n", burnin_p[pt].seed);
+            }
+        }
+        printf("  <burnin_seconds>%.3f</burnin_seconds>\n", burnins.seconds);
+        job_queue_free(&burnins);
+    }
+
+    // One job per point and replicate, run by a pool of threads:
+    Params *sim_p = (Params*)malloc(n_points * n_sims * sizeof(Params));
+    job_queue jobs;
+    job_queue_init(&jobs);
+
+    for (int pt = 0; pt < n_points; ++pt)
+    {
+        for (int i = 0; i < n_sims; ++i)
+        {
+            Params *q = &sim_p[pt * n_sims + i];
+            *q = points[pt];
+            q->replicate = i;
+            if (points[pt].seed != 0)
+            {
+                q->seed = points[pt].seed + i;
+            }
+            // Only the generations after the burn-in:
+            job_queue_add(&jobs, (void*)q, expected_cost(q) * (q->k_gen - q->burnin) / q->k_gen);
+        }
+    }
+    // The workers of a simulation inherit the processors of its thread, so give them a node:
+    bool has_workers = false;
+    for (int pt = 0; pt < n_points; ++pt)
     {
-        pthread_create(&threads[i], NULL, sim, (void*)&p);
+        has_workers = has_workers || points[pt].workers > 0;
+    }
+    affinity places;
+    affinity_init(&places, placement, has_workers);
+    affinity_print(&places, n_threads < jobs.n_jobs ? n_threads : jobs.n_jobs, stdout);
+    if (placement != AFFINITY_NONE)
+    {
+        job_queue_set_affinity(&jobs, &places);
+    }
+    job_queue_run(&jobs, n_threads, sim);
+    // The seeds, in the order of the jobs (the simulations write back those from /dev/urandom):
+    for (int i = 0; i < jobs.n_jobs; ++i)
+    {
+        printf("  <seed>%u</seed>\n", sim_p[i].seed);
+    }
+    job_queue_print(&jobs, stdout);
+    runlog_close(&run_log);
+    if (queue > 0)
+    {
+        // Waits for the last files:
+        writer_free(&output);
+        writer_print(&output, stdout);
     }
 
-    // Wait for the threads to end:
-    for (int i = 0; i < n_threads; ++i)
+    if (ensembles != NULL)
     {
-        pthread_join(threads[i], NULL);
+        // One summary per point:
+        char *buffer = (char*)malloc(100);
+        for (int pt = 0; pt < n_points; ++pt)
+        {
+            if (sw.n_points > 0)
+            {
+                sprintf(buffer, "%s%d-ensemble.xml", p.ofilename, pt);
+            }
+            else
+            {
+                sprintf(buffer, "%sensemble.xml", p.ofilename);
+            }
+            FILE *summary = fopen(buffer, "w");
+            ensemble_print(&ensembles[pt], summary);
+            fclose(summary);
+            ensemble_free(&ensembles[pt]);
+        }
+        free(ensembles);
+        free(buffer);
     }
 
+    if (sw.n_points > 0)
+    {
+        char *buffer = (char*)malloc(100);
+        sprintf(buffer, "%ssweep.xml", p.ofilename);
+        FILE *index = fopen(buffer, "w");
+        print_sweep_index(&sw, sim_p, &jobs, index);
+        fclose(index);
+        free(buffer);
+        for (int pt = 0; pt < sw.n_points; ++pt)
+        {
+            free(points[pt].shape);
+        }
+    }
+
+    job_queue_free(&jobs);
+    affinity_free(&places);
+    if (snapshots != NULL)
+    {
+        for (int pt = 0; pt < n_points; ++pt)
+        {
+            checkpoint_free(&snapshots[pt]);
+        }
+        free(snapshots);
+        free(burnin_p);
+    }
+    sweep_free(&sw);
+    free(sim_p);
+    free(points);
+
     const time_t end_t = time(NULL);
     printf("  <seconds>%lu</seconds>\n", (unsigned long)(end_t - start));
     printf("  <time>%s</time>\n", sec_to_string(end_t - start));
@@ -247,19 +777,73 @@ void *sim(void *parameters)
     const double s = P.s;
     const double radius = P.r;
     const double width = P.w;
+    const int sampler = P.sampler;
+    const int migration = P.migration;
+    const int state = P.state;
+
+    // The checkpoint to resume from, or the snapshot of the burn-in. It
+    // must have been written with the same parameters. A resumed simulation
+    // gets the seed and random streams of the checkpoint, a replicate
+    // branching from the burn-in keeps its own:
+    const bool branching = P.snapshot != NULL && !P.burning;
+    const bool restoring = P.resume != NULL || branching;
+    checkpoint saved;
+    unsigned int saved_seed = 0;
+    int k_start = 0;
+    // The first group simulated by the replicate itself:
+    int k_first = 0;
+    if (restoring)
+    {
+        checkpoint_init(&saved, NULL);
+        const bool loaded = branching ? checkpoint_copy(&saved, P.snapshot) : checkpoint_load(&saved, P.resume);
+        if (!loaded || !read_checkpoint_header(&saved, &P, &saved_seed, &k_first, &k_start))
+        {
+            fprintf(stderr, "Can't resume from %s (missing, corrupted, or written with other parameters).\n", branching ? "the burn-in" : P.resume);
+            checkpoint_free(&saved);
+            return NULL;
+        }
+        if (branching)
+        {
+            k_first = k_start;
+        }
+    }
 
-    // GSL's Taus generator:
-    gsl_rng *rng = gsl_rng_alloc(gsl_rng_taus2);
-    // Initialize the GSL generator with /dev/urandom:
-    const unsigned int seed = devurandom_get_uint();
-    gsl_rng_set(rng, seed); // Seed with time
-    printf("  <seed>%u</seed>\n", seed);
+    // Initialize the generator with the seed or /dev/urandom:
+    const unsigned int seed = P.resume != NULL ? saved_seed : (P.seed != 0 ? P.seed : devurandom_get_uint());
+    // Generator for the setup. With Philox, the events of each community
+    // use their own substream, so the numbers drawn in a community do not
+    // depend on the order in which the communities are processed.
+    rng_stream rng;
+    rng_stream *community_rng = NULL;
+    rng_stream **rngs = (rng_stream**)malloc(communities * sizeof(rng_stream*));
+    if (P.rng == RNG_PHILOX)
+    {
+        rng_stream_init_philox(&rng, seed, P.replicate, 0);
+        community_rng = (rng_stream*)malloc(communities * sizeof(rng_stream));
+        for (int c = 0; c < communities; ++c)
+        {
+            rng_stream_init_philox(&community_rng[c], seed, P.replicate, 1 + c);
+            rngs[c] = &community_rng[c];
+        }
+    }
+    else
+    {
+        rng_stream_init(&rng, P.rng, seed);
+        for (int c = 0; c < communities; ++c)
+        {
+            rngs[c] = &rng;
+        }
+    }
+    // The seed drawn from /dev/urandom, for the main output and the index of a sweep:
+    ((Params*)parameters)->seed = seed;
     // Used to name the output file:
     char *buffer = (char*)malloc(100);
     // Nme of the file:
-    sprintf(buffer, "%s%u.xml", P.ofilename, seed);
-    // Open the output file:
-    FILE *restrict out = fopen(buffer, "w");
+    output_filename((Params*)parameters, results_extension(P.format), buffer);
+    // Open the output file (the text goes to 'out', the parameters and the numbers through 'res'):
+    results res;
+    results_open(&res, P.files ? buffer : NULL, P.format, P.output);
+    FILE *restrict out = res.out;
     // Store the total num. of species/1000 generations:
     int *restrict total_species = (int*)malloc(k_gen * sizeof(int));
     // Number of speciation events/1000 generations:
@@ -286,11 +870,15 @@ void *sim(void *parameters)
     }
     // Initialize an empty list of species:
     species_list *restrict list = species_list_init();
+    // The species of the list engine come from a pool, sized for a few times the initial species:
+    species_pool pool;
+    species_pool_init(&pool, communities, 3, 4 * init_species);
+    list->pool = &pool;
     // Initialize the metacommunity and fill them with the initial species evenly:
     for (int i = 0; i < init_species; ++i)
     {
         // Intialize the species and add it to the list:
-        species_list_add(list, species_init(communities, 0, 3));
+        species_list_add(list, species_pool_species(&pool, 0));
     }
     // To iterate the list;
     slnode *it = list->head;
@@ -300,6 +888,7 @@ void *sim(void *parameters)
         for (int i = 0; i < communities; ++i)
         {
             it->sp->n[i] = init_pop_size;
+            it->sp->total += init_pop_size;
             it->sp->genotypes[0][i] = init_pop_size;
         }
         it = it->next;
@@ -313,6 +902,7 @@ void *sim(void *parameters)
         for (int j = 0; j < remainder; ++j, it = it->next)
         {
             ++(it->sp->n[i]);
+            ++(it->sp->total);
             ++(it->sp->genotypes[0][i]);
         }
     }
@@ -352,236 +942,291 @@ void *sim(void *parameters)
         if (shape[1] == 'e')
         {
             shape = "rectangle";
-            graph_get_rec_crgg(&g, communities, width, radius, x, y, rng);
+            graph_get_rec_crgg(&g, communities, width, radius, x, y, &rng);
             break;
         }
         else
         {
             shape = "random";
-            graph_get_crgg(&g, communities, radius, x, y, rng);
+            graph_get_crgg(&g, communities, radius, x, y, &rng);
             break;
         }
     default:
         shape = "random";
-        graph_get_crgg(&g, communities, radius, x, y, rng);
+        graph_get_crgg(&g, communities, radius, x, y, &rng);
+    }
+    if (restoring)
+    {
+        // The graph of the checkpoint replaces the one just drawn (the same
+        // for the same seed, but the checkpoint is the reference):
+        graph_free(&g);
+        checkpoint_get_graph(&saved, &g);
+        checkpoint_get(&saved, x, communities * sizeof(double));
+        checkpoint_get(&saved, y, communities * sizeof(double));
+    }
+    // Once complete, the graph is only read, in its frozen form:
+    graph_csr csr;
+    graph_csr_init(&csr, &g);
+    graph_free(&g);
+    // Setup the cumulative jagged array or the alias tables for migration:
+    double **cumul = NULL;
+    migration_sampler ms;
+    if (migration == MIGRATION_ALIAS)
+    {
+        migration_sampler_init(&ms, &csr, omega);
+    }
+    else
+    {
+        cumul = setup_cumulative_list(&csr, omega);
     }
-    // Setup the cumulative jagged array for migration:
-    double **cumul = setup_cumulative_list(&g, omega);
 
     fprintf(out, "<?xml version=\"1.0\"?>\n");
     fprintf(out, "<simulation>\n");
-    fprintf(out, "  <model>");
-    if (P.m == MODEL_BDM_NEUTRAL)
+    if (P.m == MODEL_BDM_NEUTRAL && P.engine == ENGINE_COALESCENT)
+    {
+        results_param_text(&res, 2, "model", "Neutral lineage speciation");
+    }
+    else if (P.m == MODEL_BDM_NEUTRAL)
     {
-        fprintf(out, "Neutral BDM speciation</model>\n");
+        results_param_text(&res, 2, "model", "Neutral BDM speciation");
     }
     else if (P.m == MODEL_BDM_SELECTION)
     {
-        fprintf(out, "BDM speciation with selection</model>\n");
-    }
-    fprintf(out, "  <seed>%u</seed>\n", seed);
-    fprintf(out, "  <shape_metacom>%s</shape_metacom>\n", shape);
-    fprintf(out, "  <metacom_size>%d</metacom_size>\n", j_per_c * communities);
-    fprintf(out, "  <k_gen>%d</k_gen>\n", k_gen);
-    fprintf(out, "  <num_comm>%d</num_comm>\n", communities);
-    fprintf(out, "  <individuals_per_comm>%d</individuals_per_comm>\n", j_per_c);
-    fprintf(out, "  <initial_num_species>%d</initial_num_species>\n", init_species);
-    fprintf(out, "  <mutation_rate>%.2e</mutation_rate>\n", mu);
-    fprintf(out, "  <omega>%.2e</omega>\n", omega);
+        results_param_text(&res, 2, "model", "BDM speciation with selection");
+    }
+    results_param_text(&res, 2, "speciation_rule", speciation_rule(P.engine));
+    results_param_int(&res, 2, "seed", seed);
+    results_param_int(&res, 2, "replicate", P.replicate);
+    if (P.point >= 0)
+    {
+        results_param_int(&res, 2, "sweep_point", P.point);
+    }
+    results_param_text(&res, 2, "shape_metacom", shape);
+    results_param_int(&res, 2, "metacom_size", j_per_c * communities);
+    results_param_int(&res, 2, "k_gen", k_gen);
+    results_param_int(&res, 2, "num_comm", communities);
+    results_param_int(&res, 2, "individuals_per_comm", j_per_c);
+    results_param_int(&res, 2, "initial_num_species", init_species);
+    results_param_real(&res, 2, "mutation_rate", mu, 'e', 2);
+    results_param_real(&res, 2, "omega", omega, 'e', 2);
     if (P.m == MODEL_BDM_SELECTION)
     {
-        fprintf(out, "  <selection>%.2e</selection>\n", s);
+        results_param_real(&res, 2, "selection", s, 'e', 2);
     }
     if (shape[0] == 'r')
     {
-        fprintf(out, "  <radius>%.4f</radius>\n", radius);
+        results_param_real(&res, 2, "radius", radius, 'f', 4);
     }
     if (shape[0] == 'r' && shape[1] == 'e')
     {
-        fprintf(out, "  <width>%.4f</width>\n", width);
+        results_param_real(&res, 2, "width", width, 'f', 4);
     }
-    // To select the species and genotypes to pick and replace:
-    slnode *s0 = list->head; // species0
-    slnode *s1 = list->head; // species1
-    int g0 = 0;
-    int g1 = 0;
-    int v1 = 0; // Vertex of the individual 1
-
-    /////////////////////////////////////////////
-    // Groups of 1 000 generations             //
-    /////////////////////////////////////////////
-    for (int k = 0; k < k_gen; ++k)
+    results_param_text(&res, 2, "engine", P.engine == ENGINE_COALESCENT ? "Coalescent" : "Forward");
+    results_param_text(&res, 2, "sampler", sampler == SAMPLER_FENWICK ? "Fenwick tree" : "Linear walk");
+    results_param_text(&res, 2, "migration", migration == MIGRATION_ALIAS ? "Alias table" : "Cumulative list");
+    if (P.workers == 0)
+    {
+        results_param_text(&res, 2, "state", state_name(state));
+    }
+    results_param_text(&res, 2, "rng", rng_stream_name(&rng));
+    // Checked at the end of every group of 1000 generations (the burn-in
+    // always runs to its end, and its groups don't count for the replicates):
+    convergence cv;
+    convergence_init(&cv, P.burning ? 0 : P.converge, P.tolerance, k_first);
+    // The progress goes to the log at the end of every group of 1000
+    // generations (the burn-in is the replicate -1):
+    runlog_sim rs;
+    runlog_sim_start(&rs, P.log, P.point, P.burning ? -1 : P.replicate, seed, k_gen, k_start, 1000.0 * communities * j_per_c);
+    if (P.engine == ENGINE_COALESCENT)
+    {
+        /////////////////////////////////////////////
+        // Backward coalescent                     //
+        /////////////////////////////////////////////
+        // Only the final metacommunity is sampled, see coalescent.h. The
+        // series per 1000 generations only count the extant species.
+        coalescent co;
+        coalescent_init(&co, communities, j_per_c, k_gen, mu);
+        coalescent_run(&co, &ms, &rng);
+        coalescent_print_report(&co, out);
+        for (int k = 0; k < k_gen; ++k)
+        {
+            speciation_events[k] = 0;
+            extinction_events[k] = 0;
+            total_species[k] = 0;
+        }
+        species_list_free(list);
+        list = coalescent_to_species_list(&co, init_species, &rng, speciation_events, speciation_per_c);
+        coalescent_free(&co);
+        // Extant species already present at the end of each 1000 generations:
+        for (it = list->head; it != NULL; it = it->next)
+        {
+            total_species[it->sp->birth / 1000]++;
+        }
+        for (int k = 1; k < k_gen; ++k)
+        {
+            total_species[k] += total_species[k - 1];
+        }
+    }
+    else if (P.workers > 0)
     {
-        extinction_events[k] = 0;
-        speciation_events[k] = 0;
+        /////////////////////////////////////////////
+        // Parallel engine                         //
+        /////////////////////////////////////////////
+        // The communities are split between the workers, see parallel.h.
+        metacom mc;
+        metacom_init_from_list(&mc, list, false);
+        parallel_engine pe;
+        parallel_init(&pe, P.m, &mc, &csr, &ms, community_rng, j_per_c, k_gen, P.workers, P.sync, mu, s);
+        parallel_set_stats(&pe, speciation_events, extinction_events, total_species, speciation_per_c, extinction_per_c, &lifespan, &pop_size);
+        parallel_set_convergence(&pe, &cv);
+        parallel_set_progress(&pe, &rs);
+        metacom_free(&mc);
+        parallel_run(&pe);
+        parallel_print_report(&pe, out);
 
+        species_list_free(list);
+        list = parallel_to_species_list(&pe);
+        parallel_free(&pe);
+    }
+    else
+    {
         /////////////////////////////////////////////
-        // 1 000 generations                       //
+        // Groups of 1 000 generations             //
         /////////////////////////////////////////////
-        for (int gen = 0; gen < 1000; ++gen)
+        // The loops are specialised per model and state, see forward.h.
+        forward fw;
+        forward_init(&fw, P.m, state, sampler, migration, P.skip, omega, list, &csr, &ms, cumul, rngs, j_per_c, mu, s);
+        forward_set_stats(&fw, speciation_events, extinction_events, total_species, speciation_per_c, extinction_per_c, &lifespan, &pop_size);
+        if (state == STATE_INDIVIDUALS)
+        {
+            fprintf(out, "  <individuals_memory>%lu</individuals_memory>\n", (unsigned long)individuals_memory(&fw.ind));
+        }
+        if (restoring)
+        {
+            // The statistics, random streams and species at the checkpoint:
+            checkpoint_get_ints(&saved, speciation_events, k_start);
+            checkpoint_get_ints(&saved, extinction_events, k_start);
+            checkpoint_get_ints(&saved, total_species, k_start);
+            checkpoint_get_ints(&saved, speciation_per_c, communities);
+            checkpoint_get_ints(&saved, extinction_per_c, communities);
+            checkpoint_get_ivector(&saved, &lifespan);
+            checkpoint_get_ivector(&saved, &pop_size);
+            // The replicates of a burn-in skip its streams:
+            rng_stream skipped;
+            rng_stream_init(&skipped, P.rng, 0);
+            checkpoint_get_rng(&saved, branching ? &skipped : &rng);
+            for (int c = 0; community_rng != NULL && c < communities; ++c)
+            {
+                checkpoint_get_rng(&saved, branching ? &skipped : &community_rng[c]);
+            }
+            rng_stream_free(&skipped);
+            species_pool_reserve(&pool, checkpoint_get_int(&saved));
+            if (!forward_restore(&fw, &saved))
+            {
+                fprintf(stderr, "The checkpoint %s is inconsistent.\n", branching ? "of the burn-in" : P.resume);
+                exit(EXIT_FAILURE);
+            }
+            if (branching)
+            {
+                // Otherwise every replicate would wait for the burn-in's next migration and mutation:
+                forward_redraw_countdowns(&fw);
+            }
+            checkpoint_free(&saved);
+            fprintf(out, branching ? "  <burnin_k>%d</burnin_k>\n" : "  <resumed_at_k>%d</resumed_at_k>\n", k_start);
+        }
+        // Checkpoints at the end of every 'P.checkpoint' groups of 1000 generations:
+        checkpoint ck;
+        if (P.checkpoint > 0)
+        {
+            output_filename((Params*)parameters, ".ckpt", buffer);
+            checkpoint_init(&ck, buffer);
+        }
+        for (int k = k_start; k < k_gen; ++k)
         {
-            const int current_date = (k * 1000) + gen;
-            /////////////////////////////////////////////
-            // A single generation                     //
-            /////////////////////////////////////////////
-            for (int t = 0; t < j_per_c; ++t)
+            forward_run_k(&fw, k);
+            runlog_sim_progress(&rs, k, total_species[k]);
+            // The series are on the disk as soon as they are known:
+            results_stream_ints(&res, "global/speciation_per_k_gen", speciation_events, k + 1);
+            results_stream_ints(&res, "global/extinctions_per_k_gen", extinction_events, k + 1);
+            results_stream_ints(&res, "global/extant_species_per_k_gen", total_species, k + 1);
+            if (convergence_check(&cv, total_species, speciation_events, extinction_events, k))
             {
-                /////////////////////////////////////////////
-                // A single time step (for each community) //
-                /////////////////////////////////////////////
-                for (int c = 0; c < communities; ++c)
+                break;
+            }
+            // The end of the burn-in goes to its snapshot, in memory:
+            const bool periodic = P.checkpoint > 0 && (k + 1) % P.checkpoint == 0 && k + 1 < k_gen;
+            if (periodic || (P.burning && k + 1 == k_gen))
+            {
+                checkpoint *target = periodic ? &ck : P.snapshot;
+                checkpoint_begin(target);
+                write_checkpoint_header(target, &P, seed, k_first, k + 1);
+                checkpoint_put_graph(target, &csr);
+                checkpoint_put(target, x, communities * sizeof(double));
+                checkpoint_put(target, y, communities * sizeof(double));
+                checkpoint_put_ints(target, speciation_events, k + 1);
+                checkpoint_put_ints(target, extinction_events, k + 1);
+                checkpoint_put_ints(target, total_species, k + 1);
+                checkpoint_put_ints(target, speciation_per_c, communities);
+                checkpoint_put_ints(target, extinction_per_c, communities);
+                checkpoint_put_ivector(target, &lifespan);
+                checkpoint_put_ivector(target, &pop_size);
+                checkpoint_put_rng(target, &rng);
+                for (int c = 0; community_rng != NULL && c < communities; ++c)
                 {
-                    // Select the species and genotype of the individual to be replaced
-                    int position = (int)(gsl_rng_uniform(rng) * j_per_c);
-                    s0 = list->head;
-                    int index = s0->sp->n[c];
-                    while (index <= position)
-                    {
-                        s0 = s0->next;
-                        index += s0->sp->n[c];
-                    }
-                    position = (int)(gsl_rng_uniform(rng) * s0->sp->n[c]);
-                    if (position < s0->sp->genotypes[0][c])
-                    {
-                        g0 = 0;
-                    }
-                    else if (position < (s0->sp->genotypes[0][c] + s0->sp->genotypes[1][c]))
-                    {
-                        g0 = 1;
-                    }
-                    else
-                    {
-                        g0 = 2;
-                    }
-                    // Choose the vertex for the individual
-                    const double r_v1 = gsl_rng_uniform(rng);
-                    v1 = 0;
-                    while (r_v1 > cumul[c][v1])
-                    {
-                        ++v1;
-                    }
-                    v1 = g.adj_list[c][v1];
-                    // species of the new individual
-                    position = (int)(gsl_rng_uniform(rng) * j_per_c);
-                    s1 = list->head;
-                    index = s1->sp->n[v1];
-                    while (index <= position)
-                    {
-                        s1 = s1->next;
-                        index += s1->sp->n[v1];
-                    }
-                    if (v1 == c) // local remplacement
-                    {
-                        const double r = gsl_rng_uniform(rng);
-                        const int aa = s1->sp->genotypes[0][v1];
-                        const int Ab = s1->sp->genotypes[1][v1];
-                        const int AB = s1->sp->genotypes[2][v1];
-
-                        // The total fitness of the population 'W':
-                        const double w = aa + Ab * (1.0 + s) + AB * (1.0 + s) * (1.0 + s);
-
-                        if (r < aa / w)
-                        {
-                            g1 = gsl_rng_uniform(rng) < mu ? 1 : 0;
-                        }
-                        else
-                        {
-                            if (AB == 0 || r < (aa + Ab * (1.0 + s)) / w)
-                            {
-                                g1 = gsl_rng_uniform(rng) < mu ? 2 : 1;
-                            }
-                            else
-                            {
-                                g1 = 2;
-                            }
-                        }
-                    }
-                    else
-                    { // Migration event
-                        g1 = 0;
-                    }
-                    // Apply the changes
-                    s0->sp->n[c]--;
-                    s0->sp->genotypes[g0][c]--;
-                    s1->sp->n[c]++;
-                    s1->sp->genotypes[g1][c]++;
-
-                    ////////////////////////////////////////////
-                    // Check for local extinction             //
-                    ////////////////////////////////////////////
-                    if (s0->sp->n[c] == 0)
-                    {
-                        extinction_per_c[c]++;
-                    }
-                    ////////////////////////////////////////////
-                    // Check for speciation                   //
-                    ////////////////////////////////////////////
-                    else if (s0->sp->genotypes[2][c] > 0 && s0->sp->genotypes[0][c] == 0 && s0->sp->genotypes[1][c] == 0)
-                    {
-                        species_list_add(list, species_init(communities, current_date, 3)); // Add the new species
-
-                        const int pop = s0->sp->n[c];
-                        list->tail->sp->n[c] = pop;
-                        list->tail->sp->genotypes[0][c] = pop;
-                        s0->sp->n[c] = 0;
-                        s0->sp->genotypes[2][c] = 0;
-
-                        // To keep info on patterns of speciation...
-                        ivector_add(&pop_size, pop);
-                        ++speciation_events[k];
-                        ++speciation_per_c[c];
-                    }
-
-                } // End 'c'
-
-            } // End 't'
-
-            // Remove extinct species from the list and store the number of extinctions.
-            extinction_events[k] += species_list_rmv_extinct2(list, &lifespan, current_date);
-
-        } // End 'g'
-
-        total_species[k] = list->size;
-
-    } // End 'k'
+                    checkpoint_put_rng(target, &community_rng[c]);
+                }
+                checkpoint_put_int(target, pool.peak);
+                forward_save(&fw, target);
+                if (periodic)
+                {
+                    checkpoint_commit(&ck);
+                }
+            }
+        }
+        forward_print_kernel(&fw, out);
+        if (P.checkpoint > 0)
+        {
+            // Freed first to wait for the last write:
+            checkpoint_free(&ck);
+            checkpoint_print(&ck, out);
+        }
+
+        // The reports read the final state through a list of species:
+        species_list *final = forward_species(&fw);
+        if (final != list)
+        {
+            species_list_free(list);
+            list = final;
+        }
+        forward_free(&fw);
+    }
 
     //////////////////////////////////////////////////
     // PRINT THE FINAL RESULTS                      //
     //////////////////////////////////////////////////
-    fprintf(out, "  <global>\n");
-    fprintf(out, "    <proper_edges>%d</proper_edges>\n", graph_edges(&g));
-    fprintf(out, "    <links_per_c>%.4f</links_per_c>\n", (double)graph_edges(&g) / communities);
-
-    fprintf(out, "    <avr_lifespan>%.4f</avr_lifespan>\n", imean(lifespan.array, lifespan.size));
-    fprintf(out, "    <median_lifespan>%.4f</median_lifespan>\n", imedian(lifespan.array, lifespan.size));
-
-    fprintf(out, "    <avr_pop_size_speciation>%.4f</avr_pop_size_speciation>\n", imean(pop_size.array, pop_size.size));
-    fprintf(out, "    <median_pop_size_speciation>%.4f</median_pop_size_speciation>\n", imedian(pop_size.array, pop_size.size));
-
-    fprintf(out, "    <speciation_per_k_gen>");
-    int i = 0;
-    for (; i < k_gen - 1; ++i)
+    // The series stop where the simulation stopped:
+    const int k_done = cv.k_stop > 0 ? cv.k_stop : k_gen;
+    runlog_sim_end(&rs, k_done, total_species[k_done - 1]);
+    if (cv.window > 0)
     {
-        fprintf(out, "%d ", speciation_events[i]);
+        convergence_print(&cv, out);
     }
-    fprintf(out, "%d</speciation_per_k_gen>\n", speciation_events[i]);
+    species_pool_print(&pool, out);
+    fprintf(out, "  <global>\n");
+    results_int(&res, 4, "global/proper_edges", graph_csr_edges(&csr));
+    results_real(&res, 4, "global/links_per_c", (double)graph_csr_edges(&csr) / communities, 4);
 
-    fprintf(out, "    <extinctions_per_k_gen>");
-    for (i = 0; i < k_gen - 1; ++i)
-    {
-        fprintf(out, "%d ", extinction_events[i]);
-    }
-    fprintf(out, "%d</extinctions_per_k_gen>\n", extinction_events[i]);
+    results_real(&res, 4, "global/avr_lifespan", imean(lifespan.array, lifespan.size), 4);
+    results_real(&res, 4, "global/median_lifespan", imedian(lifespan.array, lifespan.size), 4);
 
-    fprintf(out, "    <extant_species_per_k_gen>");
-    for (i = 0; i < k_gen - 1; ++i)
-    {
-        fprintf(out, "%d ", total_species[i]);
-    }
-    fprintf(out, "%d</extant_species_per_k_gen>\n", total_species[i]);
+    results_real(&res, 4, "global/avr_pop_size_speciation", imean(pop_size.array, pop_size.size), 4);
+    results_real(&res, 4, "global/median_pop_size_speciation", imedian(pop_size.array, pop_size.size), 4);
+
+    results_ints(&res, 4, "global/speciation_per_k_gen", speciation_events, k_done);
+    results_ints(&res, 4, "global/extinctions_per_k_gen", extinction_events, k_done);
+    results_ints(&res, 4, "global/extant_species_per_k_gen", total_species, k_done);
 
     // Print global distribution
-    fprintf(out, "    <species_distribution>");
     ivector species_distribution;
     ivector_init1(&species_distribution, 128);
     it = list->head;
@@ -591,33 +1236,38 @@ void *sim(void *parameters)
         it = it->next;
     }
     ivector_sort_asc(&species_distribution);
-    ivector_print(&species_distribution, out);
-    fprintf(out, "</species_distribution>\n");
+    results_ints(&res, 4, "global/species_distribution", species_distribution.array, species_distribution.size);
 
     double *octaves;
     int oct_num = biodiversity_octaves(species_distribution.array, species_distribution.size, &octaves);
-    fprintf(out, "    <octaves>");
-    for (i = 0; i < oct_num; ++i)
+    results_reals(&res, 4, "global/octaves", octaves, oct_num, 2);
+    fprintf(out, "  </global>\n");
+
+    if (P.summary != NULL && !P.burning)
     {
-        fprintf(out, "%.2f ", octaves[i]);
+        // Each replicate has its own rows, no lock needed:
+        ensemble_fold_ints(P.summary, ENSEMBLE_RICHNESS, P.replicate, total_species, k_done);
+        ensemble_fold_ints(P.summary, ENSEMBLE_SPECIATION, P.replicate, speciation_events, k_done);
+        ensemble_fold_ints(P.summary, ENSEMBLE_EXTINCTION, P.replicate, extinction_events, k_done);
+        ivector_sort_des(&species_distribution);
+        ensemble_fold_ints(P.summary, ENSEMBLE_RANKS, P.replicate, species_distribution.array, species_distribution.size);
+        ensemble_fold_reals(P.summary, ENSEMBLE_OCTAVES, P.replicate, octaves, oct_num);
     }
-    fprintf(out, "%.2f</octaves>\n", octaves[i]);
-    fprintf(out, "  </global>\n");
 
     // Print info on all vertices
     double *restrict ric_per_c = (double*)malloc(communities * sizeof(double));
     for (int c = 0; c < communities; ++c)
     {
         fprintf(out, "  <vertex>\n");
-        fprintf(out, "    <id>%d</id>\n", c);
+        results_int(&res, 4, "vertex/id", c);
         if (shape[0] == 'r')
         {
-            fprintf(out, "    <xcoor>%.4f</xcoor>\n", x[c]);
-            fprintf(out, "    <ycoor>%.4f</ycoor>\n", y[c]);
+            results_real(&res, 4, "vertex/xcoor", x[c], 4);
+            results_real(&res, 4, "vertex/ycoor", y[c], 4);
         }
-        fprintf(out, "    <degree>%d</degree>\n", g.num_e[c] + 1);
-        fprintf(out, "    <speciation_events>%d</speciation_events>\n", speciation_per_c[c]);
-        fprintf(out, "    <extinction_events>%d</extinction_events>\n", extinction_per_c[c]);
+        results_int(&res, 4, "vertex/degree", graph_csr_outdegree(&csr, c) + 1);
+        results_int(&res, 4, "vertex/speciation_events", speciation_per_c[c]);
+        results_int(&res, 4, "vertex/extinction_events", extinction_per_c[c]);
 
         int vertex_richess = 0;
         ivector_rmvall(&species_distribution);
@@ -632,64 +1282,64 @@ void *sim(void *parameters)
         ivector_trim_small(&species_distribution, 1);
 
         ric_per_c[c] = (double)species_distribution.size;
-        fprintf(out, "    <species_richess>%d</species_richess>\n", species_distribution.size);
-        fprintf(out, "    <species_distribution>");
-        ivector_print(&species_distribution, out);
-        fprintf(out, "</species_distribution>\n");
+        results_int(&res, 4, "vertex/species_richess", species_distribution.size);
+        results_ints(&res, 4, "vertex/species_distribution", species_distribution.array, species_distribution.size);
 
         // Print octaves
         free(octaves);
         oct_num = biodiversity_octaves(species_distribution.array, species_distribution.size, &octaves);
-        fprintf(out, "    <octaves>");
-        for (i = 0; i < oct_num - 1; ++i)
-        {
-            fprintf(out, "%.2f ", octaves[i]);
-        }
-        fprintf(out, "%.2f</octaves>\n", octaves[i]);
+        results_reals(&res, 4, "vertex/octaves", octaves, oct_num, 2);
         fprintf(out, "  </vertex>\n");
     }
 
     fprintf(out, "</simulation>\n");
 
-    // GraphML output:
-    sprintf(buffer, "%s%u.graphml", P.ofilename, seed);
-    FILE *outgml = fopen(buffer, "w");
-    graph_graphml(&g, outgml, seed);
-    
-    // Print to SVG files.
-    sprintf(buffer, "%s%u.svg", P.ofilename, seed);
-    FILE *outsvg = fopen(buffer, "w");
-    graph_svg(&g, x, y, 400.0, 20.0, outsvg);
-    
-    sprintf(buffer, "%s%u-speciation.svg", P.ofilename, seed);
-    FILE *outsvgspe = fopen(buffer, "w");
-    double *spe_per_c = (double*)malloc(communities * sizeof(double));
-    for (int c = 0; c < communities; ++c)
+    // The files are handed to the writer thread, if any:
+    if (P.files)
     {
-        spe_per_c[c] = (double)speciation_per_c[c];
+        writer_file gml, svg, svgspe, svgric;
+
+        // GraphML output:
+        output_filename((Params*)parameters, ".graphml", buffer);
+        FILE *outgml = writer_open(P.output, &gml, buffer, "w");
+        graph_csr_graphml(&csr, outgml, seed);
+
+        // Print to SVG files.
+        output_filename((Params*)parameters, ".svg", buffer);
+        FILE *outsvg = writer_open(P.output, &svg, buffer, "w");
+        graph_csr_svg(&csr, x, y, 400.0, 20.0, outsvg);
+
+        output_filename((Params*)parameters, "-speciation.svg", buffer);
+        FILE *outsvgspe = writer_open(P.output, &svgspe, buffer, "w");
+        double *spe_per_c = (double*)malloc(communities * sizeof(double));
+        for (int c = 0; c < communities; ++c)
+        {
+            spe_per_c[c] = (double)speciation_per_c[c];
+        }
+        scale_0_1(spe_per_c, communities);
+        graph_csr_svg_abun(&csr, x, y, 400.0, 20.0, spe_per_c, 2, outsvgspe);
+
+        output_filename((Params*)parameters, "-richness.svg", buffer);
+        FILE *outsvgric = writer_open(P.output, &svgric, buffer, "w");
+        scale_0_1(ric_per_c, communities);
+        graph_csr_svg_abun(&csr, x, y, 400.0, 20.0, ric_per_c, 1, outsvgric);
+
+        writer_close(P.output, &gml);
+        writer_close(P.output, &svg);
+        writer_close(P.output, &svgspe);
+        writer_close(P.output, &svgric);
+        free(spe_per_c);
     }
-    scale_0_1(spe_per_c, communities);
-    graph_svg_abun(&g, x, y, 400.0, 20.0, spe_per_c, 2, outsvgspe);
-    
-    sprintf(buffer, "%s%u-richness.svg", P.ofilename, seed);
-    FILE *outsvgric = fopen(buffer, "w");
-    scale_0_1(ric_per_c, communities);
-    graph_svg_abun(&g, x, y, 400.0, 20.0, ric_per_c, 1, outsvgric);
 
     //////////////////////////////////////////////////
     // EPILOGUE...                                  //
     //////////////////////////////////////////////////
     // Close files;
-    fclose(out);
-    fclose(outgml);
-    fclose(outsvg);
-    fclose(outsvgspe);
-    fclose(outsvgric);
+    results_close(&res);
     // Free arrays;
     free(x);
     free(y);
     free(ric_per_c);
-    free(spe_per_c);
     free(buffer);
     free(total_species);
     free(octaves);
@@ -699,35 +1349,46 @@ void *sim(void *parameters)
     free(extinction_events);
     // Free structs;
     species_list_free(list);
+    species_pool_free(&pool);
     ivector_free(&species_distribution);
     ivector_free(&lifespan);
     ivector_free(&pop_size);
-    graph_free(&g);
-    gsl_rng_free(rng);
+    graph_csr_free(&csr);
+    rng_stream_free(&rng);
+    free(community_rng);
+    free(rngs);
+    if (migration == MIGRATION_ALIAS)
+    {
+        migration_sampler_free(&ms);
+    }
+    else
+    {
+        mat_free((void**)cumul, communities);
+    }
 
     return NULL;
 }
 
-double **setup_cumulative_list(const graph *g, double omega)
+double **setup_cumulative_list(const graph_csr *g, double omega)
 {
     const int num_v = g->num_v;
     double **cumul = (double**)malloc(num_v * sizeof(double*));
     for (int i = 0; i < num_v; ++i) 
     {
-        cumul[i] = (double*)malloc(g->num_e[i] * sizeof(double));
+        cumul[i] = (double*)malloc(graph_csr_outdegree(g, i) * sizeof(double));
     }
     for (int i = 0; i < num_v; ++i)
     {
-        for (int j = 0; j < g->num_e[i]; ++j)
+        for (int j = 0; j < graph_csr_outdegree(g, i); ++j)
         {
-            cumul[i][j] = g->w_list[i][j];
+            cumul[i][j] = g->weight[g->offset[i] + j];
         }
     }
     for (int i = 0; i < num_v; ++i)
     {
-        for (int j = 0; j < g->num_e[i]; ++j)
+        for (int j = 0; j < graph_csr_outdegree(g, i); ++j)
         {
-            if (i != g->adj_list[i][j])
+            if (i != g->target[g->offset[i] + j])
             {
                 cumul[i][j] = omega;
             }
@@ -740,7 +1401,7 @@ double **setup_cumulative_list(const graph *g, double omega)
     for (int i = 0; i < num_v; ++i)
     {
         double sum = 0.0;
-        const int num_e = g->num_e[i];
+        const int num_e = graph_csr_outdegree(g, i);
         for (int j = 0; j < num_e; ++j)
         {
             sum += cumul[i][j];
@@ -752,7 +1413,7 @@ double **setup_cumulative_list(const graph *g, double omega)
     }
     for (int i = 0; i < num_v; ++i)
     {
-        const int num_e = g->num_e[i];
+        const int num_e = graph_csr_outdegree(g, i);
         for (int j = 1; j < num_e - 1; ++j)
         {
             cumul[i][j] += cumul[i][j - 1];
@@ -763,7 +1424,7 @@ double **setup_cumulative_list(const graph *g, double omega)
     graph_print(g, stdout);
     for (int i = 0; i < num_v; ++i)
     {
-        const int num_e = g->num_e[i];
+        const int num_e = graph_csr_outdegree(g, i);
         for (int j = 0; j < num_e; ++j)
         {
             printf("%.4f   ", cumul[i][j]);
@@ -773,3 +1434,170 @@ double **setup_cumulative_list(const graph *g, double omega)
     */
     return cumul;
 }
+
+const char *state_name(int state)
+{
+    switch (state)
+    {
+    case STATE_DENSE:
+        return "Dense block";
+    case STATE_INDIVIDUALS:
+        return "Individual arrays";
+    default:
+        return "Species list";
+    }
+}
+
+const char *speciation_rule(int engine)
+{
+    if (engine == ENGINE_COALESCENT)
+    {
+        return "Lineage reaching AB";
+    }
+    return "Local population AB";
+}
+
+void read_params(Params *p, const char *argv[], int argc)
+{
+    read_opt_i("g", argv, argc, &p->k_gen);
+    read_opt_i("jpc", argv, argc, &p->j_per_c);
+    read_opt_i("model", argv, argc, &p->m);
+    read_opt_i("c", argv, argc, &p->communities);
+    read_opt_i("sp", argv, argc, &p->init_species);
+    read_opt_i("sampler", argv, argc, &p->sampler);
+    read_opt_i("migration", argv, argc, &p->migration);
+    read_opt_i("state", argv, argc, &p->state);
+    read_opt_i("rng", argv, argc, &p->rng);
+    int skip = 0;
+    if (read_opt_i("skip", argv, argc, &skip))
+    {
+        p->skip = skip != 0;
+    }
+    read_opt_i("engine", argv, argc, &p->engine);
+    read_opt_i("workers", argv, argc, &p->workers);
+    read_opt_i("sync", argv, argc, &p->sync);
+    read_opt_i("checkpoint", argv, argc, &p->checkpoint);
+    read_opt_i("burnin", argv, argc, &p->burnin);
+    read_opt_i("converge", argv, argc, &p->converge);
+    read_opt_d("tolerance", argv, argc, &p->tolerance);
+    read_opt_i("format", argv, argc, &p->format);
+    if (p->m == MODEL_BDM_NEUTRAL)
+    {
+        // No selection in the neutral model:
+        p->s = 0.0;
+    }
+    if (p->engine == ENGINE_COALESCENT && p->m != MODEL_BDM_NEUTRAL)
+    {
+        fprintf(stderr, "The coalescent (-engine=1) requires the neutral model (-model=0), using -engine=0.\n");
+        p->engine = ENGINE_FORWARD;
+    }
+    if (p->engine == ENGINE_COALESCENT)
+    {
+        p->workers = 0;
+        p->migration = MIGRATION_ALIAS;
+    }
+    if (p->workers > 0)
+    {
+        // The workers need one stream per community and O(1) migration:
+        p->rng = RNG_PHILOX;
+        p->migration = MIGRATION_ALIAS;
+    }
+    int seed = 0;
+    if (read_opt_i("seed", argv, argc, &seed))
+    {
+        p->seed = (unsigned int)seed;
+    }
+    read_opt_d("mu", argv, argc, &p->mu);
+    read_opt_d("omega", argv, argc, &p->omega);
+    read_opt_d("r", argv, argc, &p->r);
+    read_opt_d("w", argv, argc, &p->w);
+    read_opt_d("s", argv, argc, &p->s);
+    read_opt_s("shape", argv, argc, p->shape);
+}
+
+double expected_cost(const Params *P)
+{
+    // Number of replacements:
+    return (double)P->k_gen * 1000.0 * P->communities * P->j_per_c;
+}
+
+void output_filename(const Params *P, const char *suffix, char *buffer)
+{
+    const char *burnin = P->burning ? "burnin-" : "";
+    if (P->point >= 0)
+    {
+        sprintf(buffer, "%s%s%d-%u%s", P->ofilename, burnin, P->point, P->seed, suffix);
+    }
+    else
+    {
+        sprintf(buffer, "%s%s%u%s", P->ofilename, burnin, P->seed, suffix);
+    }
+}
+
+void print_sweep_index(const sweep *sw, const Params *sim_p, const job_queue *jobs, FILE *out)
+{
+    char *buffer = (char*)malloc(100);
+    fprintf(out, "<?xml version=\"1.0\"?>\n");
+    fprintf(out, "<sweep>\n");
+    fprintf(out, "  <points>%d</points>\n", sw->n_points);
+    fprintf(out, "  <jobs>%d</jobs>\n", jobs->n_jobs);
+    for (int pt = 0; pt < sw->n_points; ++pt)
+    {
+        fprintf(out, "  <point>\n");
+        fprintf(out, "    <id>%d</id>\n", pt);
+        fprintf(out, "    <options>");
+        sweep_print_point(sw, pt, out);
+        fprintf(out, "</options>\n");
+        fprintf(out, "  </point>\n");
+    }
+    // The jobs are in the order of the points and replicates:
+    for (int i = 0; i < jobs->n_jobs; ++i)
+    {
+        const Params *P = &sim_p[i];
+        output_filename(P, results_extension(P->format), buffer);
+        fprintf(out, "  <job>\n");
+        fprintf(out, "    <id>%d</id>\n", i);
+        fprintf(out, "    <point>%d</point>\n", P->point);
+        fprintf(out, "    <replicate>%d</replicate>\n", P->replicate);
+        fprintf(out, "    <seed>%u</seed>\n", P->seed);
+        fprintf(out, "    <file>%s</file>\n", buffer);
+        fprintf(out, "    <seconds>%.3f</seconds>\n", jobs->jobs[i].seconds);
+        fprintf(out, "  </job>\n");
+    }
+    fprintf(out, "</sweep>\n");
+    free(buffer);
+}
+
+void write_checkpoint_header(checkpoint *ck, const Params *P, unsigned int seed, int k_first, int k_done)
+{
+    checkpoint_put_int(ck, CHECKPOINT_VERSION);
+    checkpoint_put_int(ck, k_first);
+    checkpoint_put_int(ck, k_done);
+    checkpoint_put(ck, &seed, sizeof(unsigned int));
+    checkpoint_put_int(ck, P->replicate);
+    checkpoint_put_int(ck, P->k_gen);
+    const int values[] = { P->m, P->communities, P->j_per_c, P->init_species, P->sampler, P->migration, P->state, P->rng, P->engine, P->skip ? 1 : 0, P->shape[0], P->shape[1] };
+    checkpoint_put_ints(ck, values, sizeof(values) / sizeof(int));
+    const double reals[] = { P->mu, P->omega, P->s, P->r, P->w };
+    checkpoint_put(ck, reals, sizeof(reals));
+}
+
+bool read_checkpoint_header(checkpoint *ck, const Params *P, unsigned int *seed, int *k_first, int *k_done)
+{
+    if (checkpoint_get_int(ck) != CHECKPOINT_VERSION)
+    {
+        return false;
+    }
+    *k_first = checkpoint_get_int(ck);
+    *k_done = checkpoint_get_int(ck);
+    checkpoint_get(ck, seed, sizeof(unsigned int));
+    checkpoint_get_int(ck); // The replicate and number of generations, informative.
+    checkpoint_get_int(ck);
+    const int values[] = { P->m, P->communities, P->j_per_c, P->init_species, P->sampler, P->migration, P->state, P->rng, P->engine, P->skip ? 1 : 0, P->shape[0], P->shape[1] };
+    int saved_values[sizeof(values) / sizeof(int)];
+    checkpoint_get_ints(ck, saved_values, sizeof(values) / sizeof(int));
+    const double reals[] = { P->mu, P->omega, P->s, P->r, P->w };
+    double saved_reals[sizeof(reals) / sizeof(double)];
+    checkpoint_get(ck, saved_reals, sizeof(reals));
+    return ck->ok && *k_done > 0 && *k_done < P->k_gen && memcmp(values, saved_values, sizeof(values)) == 0 && memcmp(reals, saved_reals, sizeof(reals)) == 0;
+}
@@ -0,0 +1,237 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "common.h"
+#include "ivector.h"
+#include "fenwick.h"
+#include "species.h"
+#include "specieslist.h"
+#include "metacom.h"
+
+void metacom_init(metacom *m, int communities, int n_genotypes, int capacity, bool indexed)
+{
+    int new_capacity = 1;
+    while (new_capacity < capacity)
+    {
+        new_capacity <<= 1;
+    }
+    m->communities = communities;
+    m->n_genotypes = n_genotypes;
+    m->stride = 1 + n_genotypes;
+    m->capacity = new_capacity;
+    m->size = 0;
+    m->end = 0;
+    m->counts = (int*)calloc((size_t)communities * new_capacity * m->stride, sizeof(int));
+    m->birth = (int*)malloc(new_capacity * sizeof(int));
+    for (int i = 0; i < new_capacity; ++i)
+    {
+        m->birth[i] = -1;
+    }
+    m->total = (int*)calloc(new_capacity, sizeof(int));
+    ivector_init0(&m->free_slots);
+    ivector_init0(&m->pending);
+    m->index = NULL;
+    if (indexed)
+    {
+        m->index = (fenwick*)malloc(sizeof(fenwick));
+        fenwick_init(m->index, communities, new_capacity);
+    }
+}
+
+void metacom_init_from_list(metacom *m, const species_list *list, bool indexed)
+{
+    const species *first = list->head->sp;
+    metacom_init(m, first->subpops, first->n_genotypes, 2 * list->size, indexed);
+
+    for (slnode *it = list->head; it != NULL; it = it->next)
+    {
+        const int slot = metacom_add(m, it->sp->birth);
+        for (int c = 0; c < m->communities; ++c)
+        {
+            int *cell = metacom_cell(m, c, slot);
+            cell[0] = it->sp->n[c];
+            for (int i = 0; i < m->n_genotypes; ++i)
+            {
+                cell[1 + i] = it->sp->genotypes[i][c];
+            }
+        }
+    }
+    metacom_build_totals(m);
+    if (indexed)
+    {
+        metacom_build_index(m);
+    }
+}
+
+ORIGIN_INLINE int metacom_add(metacom *m, int time_of_birth)
+{
+    int slot;
+    if (m->free_slots.size > 0)
+    {
+        slot = m->free_slots.array[m->free_slots.size - 1];
+        ivector_sub1(&m->free_slots);
+    }
+    else
+    {
+        if (m->end == m->capacity)
+        {
+            metacom_grow(m);
+        }
+        slot = m->end++;
+    }
+    m->birth[slot] = time_of_birth;
+    m->size++;
+    return slot;
+}
+
+ORIGIN_INLINE int metacom_total(const metacom *m, int slot)
+{
+    return m->total[slot];
+}
+
+ORIGIN_INLINE void metacom_transfer(metacom *m, int from, int to, int n)
+{
+    m->total[to] += n;
+    m->total[from] -= n;
+    if (m->total[from] == 0)
+    {
+        ivector_add(&m->pending, from);
+    }
+}
+
+int metacom_rmv_extinct(metacom *m, ivector *lifespan, int date)
+{
+    // In ascending order, so the slots are freed (and recycled) in the same order as a full scan:
+    ivector_sort_asc(&m->pending);
+    int extinctions = 0;
+    for (int i = 0; i < m->pending.size; ++i)
+    {
+        const int slot = m->pending.array[i];
+        if (m->birth[slot] >= 0 && m->total[slot] == 0)
+        {
+            ivector_add(lifespan, date - m->birth[slot]);
+            m->birth[slot] = -1;
+            ivector_add(&m->free_slots, slot);
+            m->size--;
+            ++extinctions;
+        }
+    }
+    ivector_rmvall(&m->pending);
+    return extinctions;
+}
+
+species_list *metacom_to_species_list(const metacom *m)
+{
+    species_list *list = species_list_init();
+    for (int slot = 0; slot < m->end; ++slot)
+    {
+        if (m->birth[slot] < 0)
+        {
+            continue;
+        }
+        species *sp = species_init(m->communities, m->birth[slot], m->n_genotypes);
+        for (int c = 0; c < m->communities; ++c)
+        {
+            const int *cell = metacom_cell(m, c, slot);
+            sp->n[c] = cell[0];
+            sp->total += cell[0];
+            for (int i = 0; i < m->n_genotypes; ++i)
+            {
+                sp->genotypes[i][c] = cell[1 + i];
+            }
+        }
+        species_list_add(list, sp);
+    }
+    return list;
+}
+
+void metacom_free(metacom *m)
+{
+    free(m->counts);
+    m->counts = NULL;
+    free(m->birth);
+    m->birth = NULL;
+    free(m->total);
+    m->total = NULL;
+    ivector_free(&m->free_slots);
+    ivector_free(&m->pending);
+    if (m->index != NULL)
+    {
+        fenwick_free(m->index);
+        free(m->index);
+        m->index = NULL;
+    }
+}
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions
+
+void metacom_grow(metacom *m)
+{
+    const int old_capacity = m->capacity;
+    const int new_capacity = old_capacity << 1;
+    const size_t old_row = (size_t)old_capacity * m->stride;
+    const size_t new_row = (size_t)new_capacity * m->stride;
+
+    int *counts = (int*)calloc(m->communities * new_row, sizeof(int));
+    for (int c = 0; c < m->communities; ++c)
+    {
+        memcpy(counts + c * new_row, m->counts + c * old_row, old_row * sizeof(int));
+    }
+    free(m->counts);
+    m->counts = counts;
+
+    m->birth = (int*)realloc(m->birth, new_capacity * sizeof(int));
+    for (int i = old_capacity; i < new_capacity; ++i)
+    {
+        m->birth[i] = -1;
+    }
+    m->total = (int*)realloc(m->total, new_capacity * sizeof(int));
+    memset(m->total + old_capacity, 0, (new_capacity - old_capacity) * sizeof(int));
+    m->capacity = new_capacity;
+
+    if (m->index != NULL)
+    {
+        fenwick_reset(m->index, new_capacity);
+        metacom_build_index(m);
+    }
+}
+
+void metacom_build_index(metacom *m)
+{
+    fenwick *f = m->index;
+    fenwick_reset(f, m->capacity);
+    for (int c = 0; c < m->communities; ++c)
+    {
+        int *tree = f->tree + (size_t)c * f->capacity;
+        for (int slot = 0; slot < m->end; ++slot)
+        {
+            tree[slot] = metacom_cell(m, c, slot)[0];
+        }
+        fenwick_build(f, c);
+    }
+}
+
+void metacom_build_totals(metacom *m)
+{
+    ivector_rmvall(&m->pending);
+    for (int slot = 0; slot < m->capacity; ++slot)
+    {
+        m->total[slot] = 0;
+    }
+    for (int c = 0; c < m->communities; ++c)
+    {
+        for (int slot = 0; slot < m->end; ++slot)
+        {
+            m->total[slot] += metacom_cell(m, c, slot)[0];
+        }
+    }
+    for (int slot = 0; slot < m->end; ++slot)
+    {
+        if (m->birth[slot] >= 0 && m->total[slot] == 0)
+        {
+            ivector_add(&m->pending, slot);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef METACOM_H_
+#define METACOM_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ivector.h"
+#include "fenwick.h"
+#include "specieslist.h"
+
+/**
+ * Dense state of a metacommunity: the abundance and the genotype counts
+ * of every (community, species) pair in one contiguous block.
+ *
+ * The block is community-major: the 'stride' ints of a pair (the abundance
+ * followed by the 'n_genotypes' counts) are stored at
+ * ((c * capacity) + slot) * stride, so the species of one community are
+ * contiguous. A species keeps its slot for its whole life; slots of extinct
+ * species are recycled.
+ */
+typedef struct
+{
+    int communities; /** Number of communities. */
+
+    int n_genotypes; /** Number of distinct genotypes. */
+
+    int stride; /** Ints per (community, slot) pair (1 + n_genotypes). */
+
+    int capacity; /** Number of slots (always a power of 2). */
+
+    int size; /** Number of species. */
+
+    int end; /** One past the highest slot in use. */
+
+    int *counts; /** Abundances and genotypes, 'capacity * stride' ints per community. */
+
+    int *birth; /** Date of birth of the species in each slot (-1 for free slots). */
+
+    int *total; /** Total population of the species in each slot. */
+
+    ivector pending; /** Slots whose total dropped to 0 since the last call to metacom_rmv_extinct. */
+
+    ivector free_slots; /** Free slots below 'end'. */
+
+    fenwick *index; /** Cumulative abundances of the slots (NULL if not indexed). */
+}
+metacom;
+
+/** Return a pointer to the abundance of 'slot' in community 'c', followed by its genotypes. */
+#define metacom_cell(m,c,slot)    ((m)->counts + ((size_t)(c) * (m)->capacity + (slot)) * (m)->stride)
+
+/** Initialize an empty metacommunity. If 'indexed', maintain a Fenwick tree of the abundances. */
+void metacom_init(metacom *m, int communities, int n_genotypes, int capacity, bool indexed);
+
+/** Initialize the metacommunity with the species of the list (slots follow the order of the list). */
+void metacom_init_from_list(metacom *m, const species_list *list, bool indexed);
+
+/** Add an empty species and return its slot. Pointers from 'metacom_cell' are invalidated if the block grows. */
+int metacom_add(metacom *m, int time_of_birth);
+
+/** Return the total population of the species in 'slot'. \f$O(1)\f$. */
+int metacom_total(const metacom *m, int slot);
+
+/** Update the totals after 'n' individuals of the slot 'from' were replaced by individuals of 'to'. \f$O(1)\f$. */
+void metacom_transfer(metacom *m, int from, int to, int n);
+
+/** Remove the extinct species (only the pending slots are checked), add their lifespan to the vector, and return the number of extinctions. */
+int metacom_rmv_extinct(metacom *m, ivector *lifespan, int date);
+
+/** Return a species_list with a copy of the species (in slot order), e.g. for reports. */
+species_list *metacom_to_species_list(const metacom *m);
+
+/** Free the memory. */
+void metacom_free(metacom *m);
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions. You shouldn't need those.
+
+/** Double the number of slots. \f$O(CS)\f$. */
+void metacom_grow(metacom *m);
+
+/** Rebuild the Fenwick trees from the abundances. \f$O(CS)\f$. */
+void metacom_build_index(metacom *m);
+
+/** Recompute the totals from the abundances and queue the empty species. \f$O(CS)\f$. */
+void metacom_build_totals(metacom *m);
+
+#endif
@@ -0,0 +1,102 @@
+#include <stdlib.h>
+#include "common.h"
+#include "graph.h"
+#include "migration.h"
+
+void migration_sampler_init(migration_sampler *ms, const graph_csr *g, double omega)
+{
+    const int num_v = g->num_v;
+    ms->num_v = num_v;
+    ms->offset = g->offset;
+    ms->keep = g->target;
+    int max_e = 0;
+    for (int u = 0; u < num_v; ++u)
+    {
+        if (graph_csr_outdegree(g, u) > max_e)
+        {
+            max_e = graph_csr_outdegree(g, u);
+        }
+    }
+    const int columns = ms->offset[num_v];
+    ms->prob = (double*)malloc(columns * sizeof(double));
+    ms->alias = (int*)malloc(columns * sizeof(int));
+
+    // Work arrays for Vose's method:
+    double *scaled = (double*)malloc(max_e * sizeof(double));
+    int *small = (int*)malloc(max_e * sizeof(int));
+    int *large = (int*)malloc(max_e * sizeof(int));
+
+    for (int u = 0; u < num_v; ++u)
+    {
+        const int num_e = graph_csr_outdegree(g, u);
+        double *prob = ms->prob + ms->offset[u];
+        const int *keep = ms->keep + ms->offset[u];
+        int *alias = ms->alias + ms->offset[u];
+
+        double sum = 0.0;
+        for (int e = 0; e < num_e; ++e)
+        {
+            scaled[e] = keep[e] == u ? 1.0 : omega;
+            sum += scaled[e];
+        }
+        int n_small = 0;
+        int n_large = 0;
+        for (int e = 0; e < num_e; ++e)
+        {
+            scaled[e] *= num_e / sum;
+            alias[e] = keep[e];
+            if (scaled[e] < 1.0)
+            {
+                small[n_small++] = e;
+            }
+            else
+            {
+                large[n_large++] = e;
+            }
+        }
+        while (n_small > 0 && n_large > 0)
+        {
+            const int l = small[--n_small];
+            const int h = large[n_large - 1];
+            prob[l] = scaled[l];
+            alias[l] = keep[h];
+            scaled[h] -= 1.0 - scaled[l];
+            if (scaled[h] < 1.0)
+            {
+                --n_large;
+                small[n_small++] = h;
+            }
+        }
+        // What is left is 1.0 up to rounding errors:
+        while (n_large > 0)
+        {
+            prob[large[--n_large]] = 1.0;
+        }
+        while (n_small > 0)
+        {
+            prob[small[--n_small]] = 1.0;
+        }
+    }
+    free(scaled);
+    free(small);
+    free(large);
+}
+
+ORIGIN_INLINE int migration_sampler_draw(const migration_sampler *ms, int u, double r)
+{
+    const int first = ms->offset[u];
+    const double x = r * (ms->offset[u + 1] - first);
+    const int column = (int)x;
+    return (x - column) < ms->prob[first + column] ? ms->keep[first + column] : ms->alias[first + column];
+}
+
+void migration_sampler_free(migration_sampler *ms)
+{
+    // The offsets and vertices belong to the graph:
+    ms->offset = NULL;
+    free(ms->prob);
+    ms->prob = NULL;
+    ms->keep = NULL;
+    free(ms->alias);
+    ms->alias = NULL;
+}
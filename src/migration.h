@@ -0,0 +1,40 @@
+#ifndef MIGRATION_H_
+#define MIGRATION_H_
+
+#include "graph.h"
+
+/**
+ * Walker/Vose alias tables used to pick the community of origin of a new
+ * individual among the neighbours of each community in \f$O(1)\f$,
+ * whatever the degree.
+ *
+ * Each edge (including the loop) is a column of the table of its source
+ * vertex. Loops have a weight of 1.0 and proper edges a weight of 'omega',
+ * exactly like the cumulative list used by 'sim'. The columns are the
+ * edges of the frozen graph, whose offsets and targets are shared (the
+ * graph must outlive the tables).
+ */
+typedef struct
+{
+    int num_v; /** Number of vertices. */
+
+    const int *offset; /** First column of each vertex (num_v + 1 elements, the graph's). */
+
+    double *prob; /** Probability to keep the vertex of the column. */
+
+    const int *keep; /** Vertex of the column (the graph's). */
+
+    int *alias; /** Vertex picked when the column is not kept. */
+}
+migration_sampler;
+
+/** Build the alias tables from the edges of the graph. \f$O(|E|)\f$. */
+void migration_sampler_init(migration_sampler *ms, const graph_csr *g, double omega);
+
+/** Return the vertex of origin of an individual replacing one in 'u', given a uniform deviate 'r' in [0, 1). \f$O(1)\f$. */
+int migration_sampler_draw(const migration_sampler *ms, int u, double r);
+
+/** Free the memory of the struct. */
+void migration_sampler_free(migration_sampler *ms);
+
+#endif
@@ -0,0 +1,561 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "common.h"
+#include "ivector.h"
+#include "rng.h"
+#include "graph.h"
+#include "migration.h"
+#include "metacom.h"
+#include "individuals.h"
+#include "species.h"
+#include "specieslist.h"
+#include "utils.h"
+#include "parallel.h"
+
+void parallel_init(parallel_engine *pe, int model, const metacom *m, const graph_csr *g, const migration_sampler *ms, rng_stream *rngs, int j_per_c, int k_gen, int workers, int sync, double mu, double s)
+{
+    const int communities = m->communities;
+    if (workers > communities)
+    {
+        workers = communities;
+    }
+    pe->model = model;
+    pe->communities = communities;
+    pe->j_per_c = j_per_c;
+    pe->k_gen = k_gen;
+    pe->cv = NULL;
+    pe->progress = NULL;
+    pe->workers = workers;
+    pe->sync = (sync <= 0 || sync > j_per_c) ? j_per_c : sync;
+    pe->mu = mu;
+    pe->s = s;
+    pe->ms = ms;
+    pe->rngs = rngs;
+    pe->n_genotypes = m->n_genotypes;
+
+    individuals_init(&pe->live, m, j_per_c);
+    individuals_init(&pe->snapshot, m, j_per_c);
+
+    // Rows of counts, with the same slots as the metacom:
+    const int stride = 1 + m->n_genotypes;
+    pe->rows = (int**)malloc(communities * sizeof(int*));
+    pe->row_capacity = (int*)malloc(communities * sizeof(int));
+    pe->dirty = (ivector*)malloc(communities * sizeof(ivector));
+    pe->full_copy = (bool*)malloc(communities * sizeof(bool));
+    for (int c = 0; c < communities; ++c)
+    {
+        pe->row_capacity[c] = m->capacity;
+        pe->rows[c] = (int*)malloc((size_t)m->capacity * stride * sizeof(int));
+        memcpy(pe->rows[c], metacom_cell(m, c, 0), (size_t)m->capacity * stride * sizeof(int));
+        ivector_init0(&pe->dirty[c]);
+        pe->full_copy[c] = false;
+    }
+    pe->slot_capacity = m->capacity;
+    pe->birth = (int*)malloc(m->capacity * sizeof(int));
+    memcpy(pe->birth, m->birth, m->capacity * sizeof(int));
+    pe->end = m->end;
+    pe->size = m->size;
+    ivector_init1(&pe->free_slots, m->free_slots.size > 0 ? m->free_slots.size : VECTOR_INIT_CAPACITY);
+    ivector_add_array(&pe->free_slots, m->free_slots.array, m->free_slots.size);
+    pthread_mutex_init(&pe->lock, NULL);
+    pthread_barrier_init(&pe->barrier, NULL, workers);
+
+    // Contiguous partitions of (almost) equal sizes:
+    pe->first = (int*)malloc((workers + 1) * sizeof(int));
+    for (int w = 0; w <= workers; ++w)
+    {
+        pe->first[w] = (int)((long)w * communities / workers);
+    }
+    pe->cut_edges = 0;
+    for (int w = 0; w < workers; ++w)
+    {
+        for (int u = pe->first[w]; u < pe->first[w + 1]; ++u)
+        {
+            for (int e = g->offset[u]; e < g->offset[u + 1]; ++e)
+            {
+                const int v = g->target[e];
+                if (v > u && (v < pe->first[w] || v >= pe->first[w + 1]))
+                {
+                    ++pe->cut_edges;
+                }
+            }
+        }
+    }
+    pe->worker_speciations = (int*)calloc(workers, sizeof(int));
+    pe->worker_pop_size = (ivector*)malloc(workers * sizeof(ivector));
+    for (int w = 0; w < workers; ++w)
+    {
+        ivector_init0(&pe->worker_pop_size[w]);
+    }
+    // Running totals of the slots over the communities of each worker:
+    pe->worker_total = (int**)malloc(workers * sizeof(int*));
+    pe->worker_total_capacity = (int*)malloc(workers * sizeof(int));
+    pe->worker_pending = (ivector*)malloc(workers * sizeof(ivector));
+    for (int w = 0; w < workers; ++w)
+    {
+        pe->worker_total_capacity[w] = m->capacity;
+        pe->worker_total[w] = (int*)calloc(m->capacity, sizeof(int));
+        for (int c = pe->first[w]; c < pe->first[w + 1]; ++c)
+        {
+            for (int slot = 0; slot < m->end; ++slot)
+            {
+                pe->worker_total[w][slot] += metacom_cell(m, c, slot)[0];
+            }
+        }
+        ivector_init0(&pe->worker_pending[w]);
+    }
+    // Species that are already empty go at the end of the first generation:
+    for (int slot = 0; slot < m->end; ++slot)
+    {
+        if (m->birth[slot] >= 0 && metacom_total(m, slot) == 0)
+        {
+            ivector_add(&pe->worker_pending[0], slot);
+        }
+    }
+    pe->busy = (double*)calloc(workers, sizeof(double));
+    pe->wait = (double*)calloc(workers, sizeof(double));
+    pe->syncs = 0;
+}
+
+void parallel_set_stats(parallel_engine *pe, int *speciation_events, int *extinction_events, int *total_species, int *speciation_per_c, int *extinction_per_c, ivector *lifespan, ivector *pop_size)
+{
+    pe->speciation_events = speciation_events;
+    pe->extinction_events = extinction_events;
+    pe->total_species = total_species;
+    pe->speciation_per_c = speciation_per_c;
+    pe->extinction_per_c = extinction_per_c;
+    pe->lifespan = lifespan;
+    pe->pop_size = pop_size;
+}
+
+void parallel_set_convergence(parallel_engine *pe, convergence *cv)
+{
+    pe->cv = cv;
+}
+
+void parallel_set_progress(parallel_engine *pe, runlog_sim *progress)
+{
+    pe->progress = progress;
+}
+
+void parallel_run(parallel_engine *pe)
+{
+    pthread_t *threads = (pthread_t*)malloc(pe->workers * sizeof(pthread_t));
+    parallel_worker_arg *args = (parallel_worker_arg*)malloc(pe->workers * sizeof(parallel_worker_arg));
+    for (int w = 0; w < pe->workers; ++w)
+    {
+        args[w].pe = pe;
+        args[w].id = w;
+        pthread_create(&threads[w], NULL, parallel_worker, (void*)&args[w]);
+    }
+    for (int w = 0; w < pe->workers; ++w)
+    {
+        pthread_join(threads[w], NULL);
+    }
+    // Population sizes at speciation, in the order of the workers:
+    for (int w = 0; w < pe->workers; ++w)
+    {
+        ivector_add_array(pe->pop_size, pe->worker_pop_size[w].array, pe->worker_pop_size[w].size);
+    }
+    free(threads);
+    free(args);
+}
+
+species_list *parallel_to_species_list(const parallel_engine *pe)
+{
+    const int stride = 1 + pe->n_genotypes;
+    species_list *list = species_list_init();
+    for (int slot = 0; slot < pe->end; ++slot)
+    {
+        if (pe->birth[slot] < 0)
+        {
+            continue;
+        }
+        species *sp = species_init(pe->communities, pe->birth[slot], pe->n_genotypes);
+        for (int c = 0; c < pe->communities; ++c)
+        {
+            if (slot < pe->row_capacity[c])
+            {
+                const int *cell = pe->rows[c] + (size_t)slot * stride;
+                sp->n[c] = cell[0];
+                sp->total += cell[0];
+                for (int i = 0; i < pe->n_genotypes; ++i)
+                {
+                    sp->genotypes[i][c] = cell[1 + i];
+                }
+            }
+        }
+        species_list_add(list, sp);
+    }
+    return list;
+}
+
+void parallel_print_report(const parallel_engine *pe, FILE *out)
+{
+    double max_busy = 0.0;
+    double sum_busy = 0.0;
+    double sum_wait = 0.0;
+    for (int w = 0; w < pe->workers; ++w)
+    {
+        sum_busy += pe->busy[w];
+        sum_wait += pe->wait[w];
+        if (pe->busy[w] > max_busy)
+        {
+            max_busy = pe->busy[w];
+        }
+    }
+    fprintf(out, "  <parallel>\n");
+    fprintf(out, "    <workers>%d</workers>\n", pe->workers);
+    fprintf(out, "    <sync_interval>%d</sync_interval>\n", pe->sync);
+    fprintf(out, "    <synchronisations>%ld</synchronisations>\n", pe->syncs);
+    fprintf(out, "    <cut_edges>%d</cut_edges>\n", pe->cut_edges);
+    // Slowest worker over the average worker (1.0 is a perfect balance):
+    fprintf(out, "    <balance>%.4f</balance>\n", sum_busy > 0.0 ? max_busy * pe->workers / sum_busy : 1.0);
+    // Fraction of the time spent synchronising:
+    fprintf(out, "    <sync_overhead>%.4f</sync_overhead>\n", (sum_busy + sum_wait) > 0.0 ? sum_wait / (sum_busy + sum_wait) : 0.0);
+    for (int w = 0; w < pe->workers; ++w)
+    {
+        fprintf(out, "    <worker>\n");
+        fprintf(out, "      <id>%d</id>\n", w);
+        fprintf(out, "      <communities>%d</communities>\n", pe->first[w + 1] - pe->first[w]);
+        fprintf(out, "      <busy_seconds>%.4f</busy_seconds>\n", pe->busy[w]);
+        fprintf(out, "      <sync_seconds>%.4f</sync_seconds>\n", pe->wait[w]);
+        fprintf(out, "    </worker>\n");
+    }
+    fprintf(out, "  </parallel>\n");
+}
+
+void parallel_free(parallel_engine *pe)
+{
+    individuals_free(&pe->live);
+    individuals_free(&pe->snapshot);
+    for (int c = 0; c < pe->communities; ++c)
+    {
+        free(pe->rows[c]);
+        ivector_free(&pe->dirty[c]);
+    }
+    free(pe->rows);
+    free(pe->row_capacity);
+    free(pe->dirty);
+    free(pe->full_copy);
+    free(pe->birth);
+    ivector_free(&pe->free_slots);
+    pthread_mutex_destroy(&pe->lock);
+    pthread_barrier_destroy(&pe->barrier);
+    free(pe->first);
+    free(pe->worker_speciations);
+    for (int w = 0; w < pe->workers; ++w)
+    {
+        ivector_free(&pe->worker_pop_size[w]);
+        free(pe->worker_total[w]);
+        ivector_free(&pe->worker_pending[w]);
+    }
+    free(pe->worker_pop_size);
+    free(pe->worker_total);
+    free(pe->worker_total_capacity);
+    free(pe->worker_pending);
+    free(pe->busy);
+    free(pe->wait);
+}
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions
+
+// One replacement step in community 'c'.
+ORIGIN_FORCE_INLINE void parallel_step(parallel_engine *pe, int worker, int c, int date, const int model)
+{
+    const int stride = 1 + pe->n_genotypes;
+    const int j_per_c = pe->j_per_c;
+    rng_stream *rs = &pe->rngs[c];
+    unsigned int *live = individuals_community(&pe->live, c);
+
+    // The individual to be replaced:
+    const int position0 = rng_stream_bounded(rs, j_per_c);
+    const int sl0 = individuals_slot(live[position0]);
+    const int g0 = individuals_genotype(live[position0]);
+    // The community of origin and the parent:
+    const int v1 = migration_sampler_draw(pe->ms, c, rng_stream_uniform(rs));
+    const int position1 = rng_stream_bounded(rs, j_per_c);
+    int sl1;
+    int g1;
+    if (v1 == c) // local remplacement
+    {
+        sl1 = individuals_slot(live[position1]);
+        const int *n1 = pe->rows[c] + (size_t)sl1 * stride;
+        g1 = kernel_offspring(model, rs, n1[1], n1[2], n1[3], pe->s, pe->mu);
+    }
+    else
+    { // Migration event, from the snapshot
+        sl1 = individuals_slot(individuals_community(&pe->snapshot, v1)[position1]);
+        g1 = 0;
+        parallel_reserve_row(pe, c, sl1);
+        parallel_reserve_total(pe, worker, sl1);
+    }
+    // Apply the changes
+    int *n0 = pe->rows[c] + (size_t)sl0 * stride;
+    int *n1 = pe->rows[c] + (size_t)sl1 * stride;
+    n0[0]--;
+    n0[1 + g0]--;
+    n1[0]++;
+    n1[1 + g1]++;
+    live[position0] = individuals_entry(sl1, g1);
+    ivector_add(&pe->dirty[c], position0);
+    int *total = pe->worker_total[worker];
+    total[sl1]++;
+    if (--total[sl0] == 0)
+    {
+        ivector_add(&pe->worker_pending[worker], sl0);
+    }
+
+    // Check for local extinction
+    if (n0[0] == 0)
+    {
+        pe->extinction_per_c[c]++;
+    }
+    // Check for speciation
+    else if (n0[3] > 0 && n0[1] == 0 && n0[2] == 0)
+    {
+        const int pop = n0[0];
+        pthread_mutex_lock(&pe->lock);
+        int slot;
+        if (pe->free_slots.size > 0)
+        {
+            slot = pe->free_slots.array[pe->free_slots.size - 1];
+            ivector_sub1(&pe->free_slots);
+        }
+        else
+        {
+            if (pe->end == pe->slot_capacity)
+            {
+                pe->slot_capacity <<= 1;
+                pe->birth = (int*)realloc(pe->birth, pe->slot_capacity * sizeof(int));
+            }
+            slot = pe->end++;
+        }
+        pe->birth[slot] = date;
+        pe->size++;
+        pthread_mutex_unlock(&pe->lock);
+
+        parallel_reserve_row(pe, c, slot);
+        parallel_reserve_total(pe, worker, slot);
+        n0 = pe->rows[c] + (size_t)sl0 * stride;
+        int *new_sp = pe->rows[c] + (size_t)slot * stride;
+        new_sp[0] = pop;
+        new_sp[1] = pop;
+        n0[0] = 0;
+        n0[3] = 0;
+        individuals_relabel(&pe->live, c, sl0, slot, 0);
+        pe->full_copy[c] = true;
+        total = pe->worker_total[worker];
+        total[slot] += pop;
+        total[sl0] -= pop;
+        if (total[sl0] == 0)
+        {
+            ivector_add(&pe->worker_pending[worker], sl0);
+        }
+
+        // To keep info on patterns of speciation...
+        ivector_add(&pe->worker_pop_size[worker], pop);
+        pe->worker_speciations[worker]++;
+        pe->speciation_per_c[c]++;
+    }
+}
+
+// The loops of a worker. Always inlined with a constant 'model', which
+// gives one copy of the loops per model.
+ORIGIN_FORCE_INLINE void parallel_work(parallel_engine *pe, int w, const int model)
+{
+    const int first = pe->first[w];
+    const int last = pe->first[w + 1];
+    double t0 = seconds_monotonic();
+
+    for (int k = 0; k < pe->k_gen; ++k)
+    {
+        if (w == 0)
+        {
+            pe->speciation_events[k] = 0;
+            pe->extinction_events[k] = 0;
+        }
+        for (int gen = 0; gen < 1000; ++gen)
+        {
+            const int date = (k * 1000) + gen;
+            for (int t = 0; t < pe->j_per_c; ++t)
+            {
+                for (int c = first; c < last; ++c)
+                {
+                    parallel_step(pe, w, c, date, model);
+                }
+                const bool end_of_gen = t == pe->j_per_c - 1;
+                if (end_of_gen || (t + 1) % pe->sync == 0)
+                {
+                    double t1 = seconds_monotonic();
+                    pe->busy[w] += t1 - t0;
+                    // Everybody is done with the interval:
+                    pthread_barrier_wait(&pe->barrier);
+                    parallel_update_snapshots(pe, w);
+                    if (end_of_gen && w == 0)
+                    {
+                        for (int i = 0; i < pe->workers; ++i)
+                        {
+                            pe->speciation_events[k] += pe->worker_speciations[i];
+                        }
+                        pe->extinction_events[k] += parallel_rmv_extinct(pe, date);
+                        if (gen == 999)
+                        {
+                            pe->total_species[k] = pe->size;
+                            if (pe->progress != NULL)
+                            {
+                                runlog_sim_progress(pe->progress, k, pe->size);
+                            }
+                            if (pe->cv != NULL)
+                            {
+                                convergence_check(pe->cv, pe->total_species, pe->speciation_events, pe->extinction_events, k);
+                            }
+                        }
+                    }
+                    if (w == 0)
+                    {
+                        pe->syncs++;
+                    }
+                    // The snapshots and the slots are up to date:
+                    pthread_barrier_wait(&pe->barrier);
+                    if (end_of_gen)
+                    {
+                        pe->worker_speciations[w] = 0;
+                    }
+                    t0 = seconds_monotonic();
+                    pe->wait[w] += t0 - t1;
+                }
+            }
+        }
+        // Set by the first worker before the last barrier:
+        if (pe->cv != NULL && pe->cv->k_stop > 0)
+        {
+            break;
+        }
+    }
+}
+
+void *parallel_worker(void *arg)
+{
+    parallel_engine *pe = ((parallel_worker_arg*)arg)->pe;
+    const int w = ((parallel_worker_arg*)arg)->id;
+    if (pe->model == MODEL_BDM_NEUTRAL)
+    {
+        parallel_work_neutral(pe, w);
+    }
+    else
+    {
+        parallel_work_selection(pe, w);
+    }
+    return NULL;
+}
+
+void parallel_work_neutral(parallel_engine *pe, int worker)
+{
+    parallel_work(pe, worker, MODEL_BDM_NEUTRAL);
+}
+
+void parallel_work_selection(parallel_engine *pe, int worker)
+{
+    parallel_work(pe, worker, MODEL_BDM_SELECTION);
+}
+
+void parallel_reserve_row(parallel_engine *pe, int c, int slot)
+{
+    if (slot < pe->row_capacity[c])
+    {
+        return;
+    }
+    const int stride = 1 + pe->n_genotypes;
+    int capacity = pe->row_capacity[c];
+    while (capacity <= slot)
+    {
+        capacity <<= 1;
+    }
+    pe->rows[c] = (int*)realloc(pe->rows[c], (size_t)capacity * stride * sizeof(int));
+    memset(pe->rows[c] + (size_t)pe->row_capacity[c] * stride, 0, (size_t)(capacity - pe->row_capacity[c]) * stride * sizeof(int));
+    pe->row_capacity[c] = capacity;
+}
+
+void parallel_reserve_total(parallel_engine *pe, int worker, int slot)
+{
+    if (slot < pe->worker_total_capacity[worker])
+    {
+        return;
+    }
+    int capacity = pe->worker_total_capacity[worker];
+    while (capacity <= slot)
+    {
+        capacity <<= 1;
+    }
+    pe->worker_total[worker] = (int*)realloc(pe->worker_total[worker], capacity * sizeof(int));
+    memset(pe->worker_total[worker] + pe->worker_total_capacity[worker], 0, (capacity - pe->worker_total_capacity[worker]) * sizeof(int));
+    pe->worker_total_capacity[worker] = capacity;
+}
+
+void parallel_update_snapshots(parallel_engine *pe, int worker)
+{
+    for (int c = pe->first[worker]; c < pe->first[worker + 1]; ++c)
+    {
+        const unsigned int *live = individuals_community(&pe->live, c);
+        unsigned int *snapshot = individuals_community(&pe->snapshot, c);
+        if (pe->full_copy[c])
+        {
+            memcpy(snapshot, live, pe->j_per_c * sizeof(unsigned int));
+            pe->full_copy[c] = false;
+        }
+        else
+        {
+            const ivector *dirty = &pe->dirty[c];
+            for (int i = 0; i < dirty->size; ++i)
+            {
+                snapshot[dirty->array[i]] = live[dirty->array[i]];
+            }
+        }
+        ivector_rmvall(&pe->dirty[c]);
+    }
+}
+
+int parallel_rmv_extinct(parallel_engine *pe, int date)
+{
+    // The slots that emptied in the communities of a worker, in ascending
+    // order so they are freed (and recycled) in the same order as a full scan:
+    ivector *pending = &pe->worker_pending[0];
+    for (int w = 1; w < pe->workers; ++w)
+    {
+        ivector_add_array(pending, pe->worker_pending[w].array, pe->worker_pending[w].size);
+        ivector_rmvall(&pe->worker_pending[w]);
+    }
+    ivector_sort_asc(pending);
+    int extinctions = 0;
+    for (int i = 0; i < pending->size; ++i)
+    {
+        const int slot = pending->array[i];
+        if (pe->birth[slot] < 0)
+        {
+            continue; // Already removed
+        }
+        int total = 0;
+        for (int w = 0; w < pe->workers && total == 0; ++w)
+        {
+            if (slot < pe->worker_total_capacity[w])
+            {
+                total += pe->worker_total[w][slot];
+            }
+        }
+        if (total == 0)
+        {
+            ivector_add(pe->lifespan, date - pe->birth[slot]);
+            pe->birth[slot] = -1;
+            ivector_add(&pe->free_slots, slot);
+            pe->size--;
+            ++extinctions;
+        }
+    }
+    ivector_rmvall(pending);
+    return extinctions;
+}
@@ -0,0 +1,185 @@
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "ivector.h"
+#include "rng.h"
+#include "migration.h"
+#include "metacom.h"
+#include "individuals.h"
+#include "kernel.h"
+#include "convergence.h"
+#include "runlog.h"
+#include "specieslist.h"
+
+/**
+ * Runs one simulation on several threads: the communities are split into
+ * contiguous partitions, one per worker, and each worker applies the
+ * replacement steps of its communities.
+ *
+ * Local replacements read the current state of the community. Migrants are
+ * drawn from a snapshot of the arrays of individuals taken at the last
+ * synchronisation (every 'sync' time steps and at the end of every
+ * generation), whichever worker owns the community of origin. Each
+ * community draws from its own random stream, so for a given seed and
+ * synchronisation interval the results do not depend on the number of
+ * workers.
+ *
+ * The state is an array of individuals per community (see individuals.h)
+ * and, per community, a row of counts indexed by species slot (abundance
+ * and genotypes, like metacom) that only its worker touches.
+ */
+typedef struct
+{
+    int model; /** MODEL_BDM_NEUTRAL or MODEL_BDM_SELECTION. */
+
+    int communities; /** Number of communities. */
+
+    int j_per_c; /** Number of individuals per community. */
+
+    int k_gen; /** Number of generations (in thousands). */
+
+    int workers; /** Number of threads. */
+
+    int sync; /** Number of time steps between two synchronisations. */
+
+    double mu; /** Mutation rate. */
+
+    double s; /** Selection coefficient. */
+
+    const migration_sampler *ms; /** To pick the community of origin. */
+
+    rng_stream *rngs; /** One random stream per community. */
+
+    individuals live; /** Current individuals. */
+
+    individuals snapshot; /** Individuals at the last synchronisation. */
+
+    int **rows; /** Abundance and genotypes of each slot, one row per community. */
+
+    int *row_capacity; /** Number of slots in each row. */
+
+    ivector *dirty; /** Individuals changed since the last synchronisation, per community. */
+
+    bool *full_copy; /** True if the snapshot of the community must be copied entirely. */
+
+    int n_genotypes; /** Number of distinct genotypes. */
+
+    int *birth; /** Date of birth of the species in each slot (-1 for free slots). */
+
+    int slot_capacity; /** Size of 'birth'. */
+
+    int end; /** One past the highest slot in use. */
+
+    int size; /** Number of species. */
+
+    ivector free_slots; /** Free slots below 'end'. */
+
+    pthread_mutex_t lock; /** Protects the slots during the steps. */
+
+    pthread_barrier_t barrier; /** Synchronisation of the workers. */
+
+    int *first; /** First community of each worker ('workers' + 1 elements). */
+
+    int *worker_speciations; /** Speciation events of each worker since the last generation. */
+
+    ivector *worker_pop_size; /** Population size at speciation, per worker. */
+
+    int **worker_total; /** Total population of each slot over the communities of each worker. */
+
+    int *worker_total_capacity; /** Number of slots in 'worker_total', per worker. */
+
+    ivector *worker_pending; /** Slots whose total over the communities of the worker dropped to 0, per worker. */
+
+    int *speciation_events; /** Speciation events per 1000 generations (owned by the caller). */
+
+    int *extinction_events; /** Extinctions per 1000 generations (owned by the caller). */
+
+    int *total_species; /** Number of species per 1000 generations (owned by the caller). */
+
+    int *speciation_per_c; /** Speciation events per community (owned by the caller). */
+
+    int *extinction_per_c; /** Local extinctions per community (owned by the caller). */
+
+    ivector *lifespan; /** Lifespan of the extinct species (owned by the caller). */
+
+    ivector *pop_size; /** Population size at speciation (owned by the caller). */
+
+    double *busy; /** Seconds spent in replacement steps, per worker. */
+
+    double *wait; /** Seconds spent synchronising, per worker. */
+
+    long syncs; /** Number of synchronisations. */
+
+    int cut_edges; /** Number of edges between communities of different workers. */
+
+    convergence *cv; /** Checked at the end of every 1000 generations to stop early (NULL = never). */
+
+    runlog_sim *progress; /** Logged at the end of every 1000 generations (NULL = never). */
+}
+parallel_engine;
+
+/**
+ * Initialize the engine from the state of a metacom (each community must
+ * hold 'j_per_c' individuals) and the graph. 'rngs' must hold one stream per
+ * community and 'sync' <= 0 means once per generation.
+ */
+void parallel_init(parallel_engine *pe, int model, const metacom *m, const graph_csr *g, const migration_sampler *ms, rng_stream *rngs, int j_per_c, int k_gen, int workers, int sync, double mu, double s);
+
+/** Set the arrays and vectors where the statistics are stored (see the fields of the struct). */
+void parallel_set_stats(parallel_engine *pe, int *speciation_events, int *extinction_events, int *total_species, int *speciation_per_c, int *extinction_per_c, ivector *lifespan, ivector *pop_size);
+
+/** Stop the run once 'cv' finds the statistics stationary. */
+void parallel_set_convergence(parallel_engine *pe, convergence *cv);
+
+/** Log the progress at the end of every 1000 generations (by the first worker). */
+void parallel_set_progress(parallel_engine *pe, runlog_sim *progress);
+
+/** Run the 'k_gen' thousands of generations (fewer if the convergence stops it) on 'workers' threads. */
+void parallel_run(parallel_engine *pe);
+
+/** Return a species_list with a copy of the species (for the reports). */
+species_list *parallel_to_species_list(const parallel_engine *pe);
+
+/** Print the partitions, the balance and the cost of the synchronisations. */
+void parallel_print_report(const parallel_engine *pe, FILE *out);
+
+/** Free the memory. */
+void parallel_free(parallel_engine *pe);
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions. You shouldn't need those.
+
+/** Main function of the worker threads ('arg' points to a parallel_worker_arg). */
+void *parallel_worker(void *arg);
+
+/** The loops of a worker specialised for the neutral model. */
+void parallel_work_neutral(parallel_engine *pe, int worker);
+
+/** The loops of a worker specialised for the model with selection. */
+void parallel_work_selection(parallel_engine *pe, int worker);
+
+/** Argument of a worker thread. */
+typedef struct
+{
+    parallel_engine *pe; /** The engine. */
+
+    int id; /** Index of the worker. */
+}
+parallel_worker_arg;
+
+/** Make sure the row of 'c' has room for 'slot'. */
+void parallel_reserve_row(parallel_engine *pe, int c, int slot);
+
+/** Make sure the totals of 'worker' have room for 'slot'. */
+void parallel_reserve_total(parallel_engine *pe, int worker, int slot);
+
+/** Bring the snapshots of the communities of a worker up to date. */
+void parallel_update_snapshots(parallel_engine *pe, int worker);
+
+/** Remove the extinct species (only the pending slots are checked) and return the number of extinctions. */
+int parallel_rmv_extinct(parallel_engine *pe, int date);
+
+#endif
@@ -0,0 +1,885 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "common.h"
+#include "results.h"
+
+// First bytes of the binary files.
+static const char results_magic[8] = { 'O', 'R', 'I', 'G', 'R', 'S', 'L', 'T' };
+
+// Bytes of the fixed part of the header of a complete file.
+#define RESULTS_HEADER_BYTES   44
+
+bool results_open(results *r, const char *filename, int format, writer *async)
+{
+    r->format = format;
+    r->async = async;
+    r->filename = filename != NULL ? strdup(filename) : NULL;
+    r->text = NULL;
+    r->text_size = 0;
+    r->n_params = 0;
+    r->params_capacity = 0;
+    r->params = NULL;
+    r->n_columns = 0;
+    r->columns_capacity = 0;
+    r->columns = NULL;
+    r->n_streams = 0;
+    FILE *f = writer_open(async, &r->file, filename, format == RESULTS_BINARY ? "wb" : "w");
+    if (f == NULL)
+    {
+        free(r->filename);
+        return false;
+    }
+    if (format != RESULTS_BINARY)
+    {
+        r->out = f;
+        return true;
+    }
+    // Until the end, the file only holds the streamed series:
+    fwrite(results_magic, 1, 8, f);
+    results_put_uint(f, 4, RESULTS_VERSION);
+    results_put_uint(f, 4, 0x01020304);
+    results_put_uint(f, 4, 0);
+    writer_flush(async, &r->file);
+    r->out = open_memstream(&r->text, &r->text_size);
+    return r->out != NULL;
+}
+
+void results_param_int(results *r, int indent, const char *name, long x)
+{
+    if (r->format != RESULTS_BINARY)
+    {
+        const char *tag = results_tag(name);
+        fprintf(r->out, "%*s<%s>%ld</%s>\n", indent, "", tag, x, tag);
+        return;
+    }
+    results_field *p = results_param(r, indent, RESULTS_INT, name);
+    p->i = x;
+}
+
+void results_param_real(results *r, int indent, const char *name, double x, char notation, int decimals)
+{
+    if (r->format != RESULTS_BINARY)
+    {
+        const char *tag = results_tag(name);
+        fprintf(r->out, notation == 'e' ? "%*s<%s>%.*e</%s>\n" : "%*s<%s>%.*f</%s>\n", indent, "", tag, decimals, x, tag);
+        return;
+    }
+    results_field *p = results_param(r, indent, RESULTS_REAL, name);
+    p->notation = notation;
+    p->decimals = decimals;
+    p->x = x;
+}
+
+void results_param_text(results *r, int indent, const char *name, const char *x)
+{
+    if (r->format != RESULTS_BINARY)
+    {
+        const char *tag = results_tag(name);
+        fprintf(r->out, "%*s<%s>%s</%s>\n", indent, "", tag, x, tag);
+        return;
+    }
+    results_field *p = results_param(r, indent, RESULTS_TEXT, name);
+    p->text = strdup(x);
+}
+
+void results_ints(results *r, int indent, const char *name, const int *x, int n)
+{
+    if (r->format == RESULTS_BINARY)
+    {
+        results_add_part(r, results_column(r, RESULTS_INT, 0, name), indent, x, n);
+        return;
+    }
+    const char *tag = results_tag(name);
+    fprintf(r->out, "%*s<%s>", indent, "", tag);
+    for (int i = 0; i < n; ++i)
+    {
+        fprintf(r->out, i < n - 1 ? "%d " : "%d", x[i]);
+    }
+    fprintf(r->out, "</%s>\n", tag);
+}
+
+void results_reals(results *r, int indent, const char *name, const double *x, int n, int decimals)
+{
+    if (r->format == RESULTS_BINARY)
+    {
+        results_add_part(r, results_column(r, RESULTS_REAL, decimals, name), indent, x, n);
+        return;
+    }
+    const char *tag = results_tag(name);
+    fprintf(r->out, "%*s<%s>", indent, "", tag);
+    for (int i = 0; i < n; ++i)
+    {
+        fprintf(r->out, i < n - 1 ? "%.*f " : "%.*f", decimals, x[i]);
+    }
+    fprintf(r->out, "</%s>\n", tag);
+}
+
+void results_int(results *r, int indent, const char *name, int x)
+{
+    results_ints(r, indent, name, &x, 1);
+}
+
+void results_real(results *r, int indent, const char *name, double x, int decimals)
+{
+    results_reals(r, indent, name, &x, 1, decimals);
+}
+
+void results_stream_ints(results *r, const char *name, const int *x, int n)
+{
+    if (r->format != RESULTS_BINARY)
+    {
+        return;
+    }
+    int index = results_stream_index(r, name);
+    if (index < 0)
+    {
+        if (r->n_streams == RESULTS_MAX_STREAMS)
+        {
+            return; // Only in the complete file.
+        }
+        index = r->n_streams++;
+        snprintf(r->streams[index], RESULTS_NAME_LENGTH, "%s", name);
+        r->streamed[index] = 0;
+    }
+    const int first = r->streamed[index];
+    if (n <= first)
+    {
+        return;
+    }
+    FILE *f = r->file.f;
+    const size_t length = strlen(r->streams[index]);
+    fputc(RESULTS_INT, f);
+    fputc((int)length, f);
+    fwrite(r->streams[index], 1, length, f);
+    results_put_uint(f, 4, (uint64_t)(n - first));
+    unsigned char *b = (unsigned char*)malloc((size_t)(n - first) * 4);
+    results_put_values(b, RESULTS_INT, 4, x + first, n - first);
+    fwrite(b, 4, n - first, f);
+    free(b);
+    r->streamed[index] = n;
+    // On the disk in case of a crash:
+    writer_flush(r->async, &r->file);
+}
+
+void results_close(results *r)
+{
+    if (r->format != RESULTS_BINARY)
+    {
+        writer_close(r->async, &r->file);
+        free(r->filename);
+        return;
+    }
+    fclose(r->out);
+    writer_close(r->async, &r->file);
+
+    // The complete file replaces the streamed series:
+    writer_file wf;
+    FILE *f = writer_open(r->async, &wf, r->filename, "wb");
+    if (f != NULL)
+    {
+        results_write(r, f);
+        writer_close(r->async, &wf);
+    }
+    free(r->text);
+    free(r->filename);
+    results_free_fields(r->params, r->n_params);
+    results_free_fields(r->columns, r->n_columns);
+}
+
+const char *results_extension(int format)
+{
+    return format == RESULTS_BINARY ? ".bin" : ".xml";
+}
+
+bool results_file_open(results_file *rf, const char *filename)
+{
+    rf->n_params = 0;
+    rf->params = NULL;
+    rf->n_columns = 0;
+    rf->columns = NULL;
+    rf->text_offset = 0;
+    rf->text_size = 0;
+    rf->in = fopen(filename, "rb");
+    if (rf->in == NULL)
+    {
+        return false;
+    }
+    FILE *in = rf->in;
+    char magic[8];
+    uint64_t version, order, state;
+    bool ok = fread(magic, 1, 8, in) == 8 && memcmp(magic, results_magic, 8) == 0;
+    ok = ok && results_get_uint(in, 4, &version) && version == RESULTS_VERSION;
+    ok = ok && results_get_uint(in, 4, &order) && order == 0x01020304;
+    ok = ok && results_get_uint(in, 4, &state) && state <= 1;
+    rf->complete = ok && state == 1;
+    if (ok && !rf->complete)
+    {
+        ok = results_file_recover(rf);
+    }
+    else if (ok)
+    {
+        uint64_t n_params, n_columns;
+        ok = results_get_uint(in, 4, &n_params) && results_get_uint(in, 4, &n_columns);
+        ok = ok && n_params <= UINT16_MAX && n_columns <= UINT16_MAX;
+        ok = ok && results_get_uint(in, 8, &rf->text_offset) && results_get_uint(in, 8, &rf->text_size);
+        if (ok)
+        {
+            rf->params = (results_field*)calloc(n_params, sizeof(results_field));
+            rf->columns = (results_field*)calloc(n_columns, sizeof(results_field));
+        }
+        for (uint64_t i = 0; ok && i < n_params; ++i)
+        {
+            results_field *p = &rf->params[rf->n_params++];
+            uint64_t type = 0, notation = 0, decimals = 0, length = 0;
+            ok = results_get_uint(in, 1, &type) && results_get_uint(in, 1, &notation);
+            ok = ok && results_get_uint(in, 1, &decimals) && results_get_uint(in, 1, &length);
+            ok = ok && results_get_name(in, length, p->name);
+            p->type = (int)type;
+            p->notation = (char)notation;
+            p->decimals = (int)decimals;
+            uint64_t bits = 0;
+            if (ok && type == RESULTS_INT)
+            {
+                ok = results_get_uint(in, 8, &bits);
+                p->i = (long)(int64_t)bits;
+            }
+            else if (ok && type == RESULTS_REAL)
+            {
+                ok = results_get_uint(in, 8, &bits);
+                memcpy(&p->x, &bits, sizeof(double));
+            }
+            else if (ok && type == RESULTS_TEXT)
+            {
+                ok = results_get_uint(in, 4, &length) && length <= INT32_MAX;
+                p->text = ok ? (char*)malloc(length + 1) : NULL;
+                ok = ok && fread(p->text, 1, length, in) == length;
+                if (ok)
+                {
+                    p->text[length] = '\0';
+                }
+            }
+            else
+            {
+                ok = false;
+            }
+        }
+        for (uint64_t i = 0; ok && i < n_columns; ++i)
+        {
+            results_field *col = &rf->columns[rf->n_columns++];
+            uint64_t type = 0, bytes = 0, decimals = 0, length = 0, size = 0, parts = 0;
+            ok = results_get_uint(in, 1, &type) && results_get_uint(in, 1, &bytes);
+            ok = ok && results_get_uint(in, 1, &decimals) && results_get_uint(in, 1, &length);
+            ok = ok && results_get_name(in, length, col->name);
+            ok = ok && results_get_uint(in, 4, &size) && results_get_uint(in, 4, &parts);
+            ok = ok && results_get_uint(in, 8, &col->offset) && results_get_uint(in, 8, &col->parts_offset);
+            ok = ok && size <= INT32_MAX && parts <= INT32_MAX && parts > 0;
+            ok = ok && (type == RESULTS_INT ? bytes == 1 || bytes == 2 || bytes == 4 : type == RESULTS_REAL && (bytes == 4 || bytes == 8));
+            // Without the sizes of the parts, they all have the same size:
+            ok = ok && (col->parts_offset != 0 || size % parts == 0);
+            col->type = (int)type;
+            col->bytes = (int)bytes;
+            col->decimals = (int)decimals;
+            col->size = (int)size;
+            col->parts = (int)parts;
+        }
+    }
+    if (!ok)
+    {
+        results_file_close(rf);
+    }
+    return ok;
+}
+
+const results_field *results_file_param(const results_file *rf, const char *name)
+{
+    for (int i = 0; i < rf->n_params; ++i)
+    {
+        if (strcmp(rf->params[i].name, name) == 0)
+        {
+            return &rf->params[i];
+        }
+    }
+    return NULL;
+}
+
+const results_field *results_file_column(results_file *rf, const char *name)
+{
+    int i = 0;
+    while (i < rf->n_columns && strcmp(rf->columns[i].name, name) != 0)
+    {
+        ++i;
+    }
+    if (i == rf->n_columns)
+    {
+        return NULL;
+    }
+    results_field *col = &rf->columns[i];
+    return col->loaded || results_file_load(rf, col) ? col : NULL;
+}
+
+void results_field_ints(const results_field *col, int *x)
+{
+    for (int i = 0; i < col->size; ++i)
+    {
+        x[i] = col->type == RESULTS_INT ? ((const int*)col->values)[i] : (int)((const double*)col->values)[i];
+    }
+}
+
+void results_field_reals(const results_field *col, double *x)
+{
+    for (int i = 0; i < col->size; ++i)
+    {
+        x[i] = col->type == RESULTS_INT ? (double)((const int*)col->values)[i] : ((const double*)col->values)[i];
+    }
+}
+
+void results_file_close(results_file *rf)
+{
+    if (rf->in != NULL)
+    {
+        fclose(rf->in);
+        rf->in = NULL;
+    }
+    results_free_fields(rf->params, rf->n_params);
+    results_free_fields(rf->columns, rf->n_columns);
+    rf->params = NULL;
+    rf->columns = NULL;
+    rf->n_params = 0;
+    rf->n_columns = 0;
+}
+
+bool results_to_xml(const char *filename, FILE *out)
+{
+    results_file rf;
+    if (!results_file_open(&rf, filename))
+    {
+        return false;
+    }
+    if (!rf.complete)
+    {
+        // The series of a simulation cut short, without the rest of the XML:
+        for (int i = 0; i < rf.n_columns; ++i)
+        {
+            results_print_part(&rf.columns[i], 0, rf.columns[i].size, 4, out);
+        }
+        results_file_close(&rf);
+        return false;
+    }
+    bool ok = fseek(rf.in, (long)rf.text_offset, SEEK_SET) == 0;
+    char *text = ok ? (char*)malloc(rf.text_size + 1) : NULL;
+    ok = ok && fread(text, 1, rf.text_size, rf.in) == rf.text_size;
+    for (int i = 0; ok && i < rf.n_columns; ++i)
+    {
+        ok = results_file_column(&rf, rf.columns[i].name) != NULL;
+    }
+    // The next part of each column:
+    int *part = (int*)calloc(rf.n_columns + 1, sizeof(int));
+    int *first = (int*)calloc(rf.n_columns + 1, sizeof(int));
+    size_t i = 0;
+    while (ok && i < rf.text_size)
+    {
+        const size_t length = strnlen(text + i, rf.text_size - i);
+        fwrite(text + i, 1, length, out);
+        i += length;
+        if (i == rf.text_size)
+        {
+            break;
+        }
+        // A marker:
+        ok = i + 5 <= rf.text_size;
+        if (!ok)
+        {
+            break;
+        }
+        const unsigned char *m = (const unsigned char*)text + i;
+        const int kind = m[1];
+        const int index = m[2] | (m[3] << 8);
+        const int indent = m[4];
+        i += 5;
+        if (kind == RESULTS_PARAM && index < rf.n_params)
+        {
+            results_print_param(&rf.params[index], indent, out);
+        }
+        else if (kind == RESULTS_COLUMN && index < rf.n_columns && part[index] < rf.columns[index].parts)
+        {
+            const results_field *col = &rf.columns[index];
+            const int n = col->part_sizes[part[index]++];
+            ok = first[index] + n <= col->size;
+            if (ok)
+            {
+                results_print_part(col, first[index], n, indent, out);
+                first[index] += n;
+            }
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+    free(part);
+    free(first);
+    free(text);
+    results_file_close(&rf);
+    return ok;
+}
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions
+
+const char *results_tag(const char *name)
+{
+    const char *slash = strrchr(name, '/');
+    return slash != NULL ? slash + 1 : name;
+}
+
+results_field *results_param(results *r, int indent, int type, const char *name)
+{
+    if (r->n_params == r->params_capacity)
+    {
+        r->params_capacity = r->params_capacity == 0 ? VECTOR_INIT_CAPACITY : r->params_capacity * VECTOR_GROW_RATE;
+        r->params = (results_field*)realloc(r->params, r->params_capacity * sizeof(results_field));
+    }
+    results_field *p = &r->params[r->n_params];
+    memset(p, 0, sizeof(results_field));
+    snprintf(p->name, RESULTS_NAME_LENGTH, "%s", name);
+    p->type = type;
+    p->notation = 'f';
+    results_marker(r, RESULTS_PARAM, r->n_params, indent);
+    ++r->n_params;
+    return p;
+}
+
+results_field *results_column(results *r, int type, int decimals, const char *name)
+{
+    for (int i = 0; i < r->n_columns; ++i)
+    {
+        if (strcmp(r->columns[i].name, name) == 0)
+        {
+            return &r->columns[i];
+        }
+    }
+    if (r->n_columns == r->columns_capacity)
+    {
+        r->columns_capacity = r->columns_capacity == 0 ? VECTOR_INIT_CAPACITY : r->columns_capacity * VECTOR_GROW_RATE;
+        r->columns = (results_field*)realloc(r->columns, r->columns_capacity * sizeof(results_field));
+    }
+    results_field *col = &r->columns[r->n_columns++];
+    memset(col, 0, sizeof(results_field));
+    snprintf(col->name, RESULTS_NAME_LENGTH, "%s", name);
+    col->type = type;
+    col->decimals = decimals;
+    col->loaded = true;
+    return col;
+}
+
+void results_add_part(results *r, results_field *col, int indent, const void *x, int n)
+{
+    const size_t size = col->type == RESULTS_INT ? sizeof(int) : sizeof(double);
+    if (n > 0)
+    {
+        if (col->size + n > col->capacity)
+        {
+            col->capacity = (col->size + n) * VECTOR_GROW_RATE;
+            col->values = realloc(col->values, col->capacity * size);
+        }
+        memcpy((char*)col->values + col->size * size, x, n * size);
+        col->size += n;
+    }
+    if (col->parts == col->parts_capacity)
+    {
+        col->parts_capacity = col->parts_capacity == 0 ? VECTOR_INIT_CAPACITY : col->parts_capacity * VECTOR_GROW_RATE;
+        col->part_sizes = (int*)realloc(col->part_sizes, col->parts_capacity * sizeof(int));
+    }
+    col->part_sizes[col->parts++] = n;
+    results_marker(r, RESULTS_COLUMN, (int)(col - r->columns), indent);
+}
+
+void results_marker(results *r, int kind, int index, int indent)
+{
+    fputc(0, r->out);
+    fputc(kind, r->out);
+    fputc(index & 0xff, r->out);
+    fputc((index >> 8) & 0xff, r->out);
+    fputc(indent, r->out);
+}
+
+void results_write(results *r, FILE *f)
+{
+    // The sizes, to know where the data starts:
+    uint64_t offset = RESULTS_HEADER_BYTES;
+    for (int i = 0; i < r->n_params; ++i)
+    {
+        const results_field *p = &r->params[i];
+        offset += 4 + strlen(p->name) + (p->type == RESULTS_TEXT ? 4 + strlen(p->text) : 8);
+    }
+    for (int i = 0; i < r->n_columns; ++i)
+    {
+        results_field *col = &r->columns[i];
+        offset += 4 + strlen(col->name) + 24;
+        col->bytes = results_column_bytes(col);
+    }
+    fwrite(results_magic, 1, 8, f);
+    results_put_uint(f, 4, RESULTS_VERSION);
+    results_put_uint(f, 4, 0x01020304);
+    results_put_uint(f, 4, 1);
+    results_put_uint(f, 4, (uint64_t)r->n_params);
+    results_put_uint(f, 4, (uint64_t)r->n_columns);
+    uint64_t data = offset;
+    for (int i = 0; i < r->n_columns; ++i)
+    {
+        const results_field *col = &r->columns[i];
+        data += (uint64_t)col->size * col->bytes + (results_same_parts(col) ? 0 : (uint64_t)col->parts * 4);
+    }
+    results_put_uint(f, 8, data);
+    results_put_uint(f, 8, r->text_size);
+
+    for (int i = 0; i < r->n_params; ++i)
+    {
+        const results_field *p = &r->params[i];
+        const size_t length = strlen(p->name);
+        fputc(p->type, f);
+        fputc(p->notation, f);
+        fputc(p->decimals, f);
+        fputc((int)length, f);
+        fwrite(p->name, 1, length, f);
+        if (p->type == RESULTS_INT)
+        {
+            results_put_uint(f, 8, (uint64_t)(int64_t)p->i);
+        }
+        else if (p->type == RESULTS_REAL)
+        {
+            uint64_t bits;
+            memcpy(&bits, &p->x, sizeof(double));
+            results_put_uint(f, 8, bits);
+        }
+        else
+        {
+            results_put_uint(f, 4, strlen(p->text));
+            fputs(p->text, f);
+        }
+    }
+    // The directory, the values of each column after the sizes of its parts:
+    for (int i = 0; i < r->n_columns; ++i)
+    {
+        const results_field *col = &r->columns[i];
+        const size_t length = strlen(col->name);
+        const bool same = results_same_parts(col);
+        fputc(col->type, f);
+        fputc(col->bytes, f);
+        fputc(col->decimals, f);
+        fputc((int)length, f);
+        fwrite(col->name, 1, length, f);
+        results_put_uint(f, 4, (uint64_t)col->size);
+        results_put_uint(f, 4, (uint64_t)col->parts);
+        results_put_uint(f, 8, offset + (same ? 0 : (uint64_t)col->parts * 4));
+        results_put_uint(f, 8, same ? 0 : offset);
+        offset += (uint64_t)col->size * col->bytes + (same ? 0 : (uint64_t)col->parts * 4);
+    }
+    for (int i = 0; i < r->n_columns; ++i)
+    {
+        const results_field *col = &r->columns[i];
+        if (!results_same_parts(col))
+        {
+            for (int j = 0; j < col->parts; ++j)
+            {
+                results_put_uint(f, 4, (uint64_t)col->part_sizes[j]);
+            }
+        }
+        unsigned char *b = (unsigned char*)malloc((size_t)col->size * col->bytes + 1);
+        results_put_values(b, col->type, col->bytes, col->values, col->size);
+        fwrite(b, col->bytes, col->size, f);
+        free(b);
+    }
+    fwrite(r->text, 1, r->text_size, f);
+}
+
+int results_column_bytes(const results_field *col)
+{
+    if (col->type == RESULTS_REAL)
+    {
+        // Single precision when no value loses anything:
+        const double *x = (const double*)col->values;
+        for (int i = 0; i < col->size; ++i)
+        {
+            if ((double)(float)x[i] != x[i])
+            {
+                return 8;
+            }
+        }
+        return 4;
+    }
+    const int *x = (const int*)col->values;
+    int bytes = 1;
+    for (int i = 0; i < col->size; ++i)
+    {
+        if (x[i] < INT16_MIN || x[i] > INT16_MAX)
+        {
+            return 4;
+        }
+        if (x[i] < INT8_MIN || x[i] > INT8_MAX)
+        {
+            bytes = 2;
+        }
+    }
+    return bytes;
+}
+
+bool results_same_parts(const results_field *col)
+{
+    for (int j = 1; j < col->parts; ++j)
+    {
+        if (col->part_sizes[j] != col->part_sizes[0])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void results_put_values(unsigned char *buffer, int type, int bytes, const void *x, int n)
+{
+    // The bytes in little-endian, whatever the order of the machine:
+    for (int i = 0; i < n; ++i)
+    {
+        uint64_t bits;
+        if (type == RESULTS_INT)
+        {
+            bits = (uint64_t)(int64_t)((const int*)x)[i];
+        }
+        else if (bytes == 4)
+        {
+            const float v = (float)((const double*)x)[i];
+            uint32_t b32;
+            memcpy(&b32, &v, 4);
+            bits = b32;
+        }
+        else
+        {
+            memcpy(&bits, (const double*)x + i, 8);
+        }
+        for (int k = 0; k < bytes; ++k)
+        {
+            *buffer++ = (unsigned char)(bits >> (8 * k));
+        }
+    }
+}
+
+void results_get_values(const unsigned char *buffer, int type, int bytes, void *x, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        uint64_t bits = 0;
+        for (int k = 0; k < bytes; ++k)
+        {
+            bits |= (uint64_t)*buffer++ << (8 * k);
+        }
+        if (type == RESULTS_INT)
+        {
+            // Sign extension of the narrow ints:
+            const uint64_t sign = (uint64_t)1 << (8 * bytes - 1);
+            ((int*)x)[i] = (int)(int64_t)((bits ^ sign) - sign);
+        }
+        else if (bytes == 4)
+        {
+            const uint32_t b32 = (uint32_t)bits;
+            float v;
+            memcpy(&v, &b32, 4);
+            ((double*)x)[i] = v;
+        }
+        else
+        {
+            memcpy((double*)x + i, &bits, 8);
+        }
+    }
+}
+
+void results_put_uint(FILE *out, int bytes, uint64_t x)
+{
+    unsigned char b[8];
+    for (int k = 0; k < bytes; ++k)
+    {
+        b[k] = (unsigned char)(x >> (8 * k));
+    }
+    fwrite(b, 1, bytes, out);
+}
+
+int results_stream_index(const results *r, const char *name)
+{
+    for (int i = 0; i < r->n_streams; ++i)
+    {
+        if (strcmp(r->streams[i], name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool results_get_uint(FILE *in, int bytes, uint64_t *x)
+{
+    unsigned char b[8];
+    if (fread(b, 1, bytes, in) != (size_t)bytes)
+    {
+        return false;
+    }
+    *x = 0;
+    for (int k = 0; k < bytes; ++k)
+    {
+        *x |= (uint64_t)b[k] << (8 * k);
+    }
+    return true;
+}
+
+bool results_get_name(FILE *in, uint64_t length, char *name)
+{
+    if (length >= RESULTS_NAME_LENGTH || fread(name, 1, length, in) != length)
+    {
+        return false;
+    }
+    name[length] = '\0';
+    return true;
+}
+
+bool results_file_load(results_file *rf, results_field *col)
+{
+    const size_t size = col->type == RESULTS_INT ? sizeof(int) : sizeof(double);
+    // Left by a failed read:
+    free(col->values);
+    free(col->part_sizes);
+    col->values = malloc((size_t)col->size * size + 1);
+    col->part_sizes = (int*)malloc((size_t)col->parts * sizeof(int));
+    bool ok = col->values != NULL && col->part_sizes != NULL;
+    if (ok && col->parts_offset == 0)
+    {
+        for (int j = 0; j < col->parts; ++j)
+        {
+            col->part_sizes[j] = col->size / col->parts;
+        }
+    }
+    else if (ok)
+    {
+        ok = fseek(rf->in, (long)col->parts_offset, SEEK_SET) == 0;
+        for (int j = 0; ok && j < col->parts; ++j)
+        {
+            uint64_t n = 0;
+            ok = results_get_uint(rf->in, 4, &n) && n <= (uint64_t)col->size;
+            col->part_sizes[j] = (int)n;
+        }
+    }
+    unsigned char *b = (unsigned char*)malloc((size_t)col->size * col->bytes + 1);
+    ok = ok && b != NULL && fseek(rf->in, (long)col->offset, SEEK_SET) == 0;
+    ok = ok && fread(b, col->bytes, col->size, rf->in) == (size_t)col->size;
+    if (ok)
+    {
+        results_get_values(b, col->type, col->bytes, col->values, col->size);
+        col->loaded = true;
+    }
+    free(b);
+    return ok;
+}
+
+bool results_file_recover(results_file *rf)
+{
+    uint64_t type, length, count;
+    char name[RESULTS_NAME_LENGTH];
+    unsigned char *b = NULL;
+    bool ok = true;
+    while (ok && results_get_uint(rf->in, 1, &type))
+    {
+        ok = type == RESULTS_INT && results_get_uint(rf->in, 1, &length);
+        ok = ok && results_get_name(rf->in, length, name) && results_get_uint(rf->in, 4, &count);
+        if (!ok)
+        {
+            // A chunk cut short by the crash, the ones before are complete:
+            ok = true;
+            break;
+        }
+        // The column with this name, or a new one:
+        int i = 0;
+        while (i < rf->n_columns && strcmp(rf->columns[i].name, name) != 0)
+        {
+            ++i;
+        }
+        if (i == rf->n_columns)
+        {
+            rf->columns = (results_field*)realloc(rf->columns, (rf->n_columns + 1) * sizeof(results_field));
+            results_field *col = &rf->columns[rf->n_columns++];
+            memset(col, 0, sizeof(results_field));
+            memcpy(col->name, name, length + 1);
+            col->type = RESULTS_INT;
+            col->bytes = 4;
+            col->parts = 1;
+            col->part_sizes = (int*)calloc(1, sizeof(int));
+            col->loaded = true;
+        }
+        results_field *col = &rf->columns[i];
+        if (count > (uint64_t)(INT32_MAX - col->size))
+        {
+            ok = false;
+            break;
+        }
+        b = (unsigned char*)realloc(b, count * 4 + 1);
+        if (fread(b, 4, count, rf->in) != count)
+        {
+            break;
+        }
+        col->values = realloc(col->values, (col->size + count) * sizeof(int) + 1);
+        results_get_values(b, RESULTS_INT, 4, (int*)col->values + col->size, (int)count);
+        col->size += (int)count;
+        col->part_sizes[0] = col->size;
+    }
+    free(b);
+    return ok;
+}
+
+void results_print_part(const results_field *col, int first, int n, int indent, FILE *out)
+{
+    const char *tag = results_tag(col->name);
+    fprintf(out, "%*s<%s>", indent, "", tag);
+    for (int i = first; i < first + n; ++i)
+    {
+        const char *sep = i < first + n - 1 ? " " : "";
+        if (col->type == RESULTS_INT)
+        {
+            fprintf(out, "%d%s", ((const int*)col->values)[i], sep);
+        }
+        else
+        {
+            fprintf(out, "%.*f%s", col->decimals, ((const double*)col->values)[i], sep);
+        }
+    }
+    fprintf(out, "</%s>\n", tag);
+}
+
+void results_print_param(const results_field *p, int indent, FILE *out)
+{
+    const char *tag = results_tag(p->name);
+    fprintf(out, "%*s<%s>", indent, "", tag);
+    if (p->type == RESULTS_INT)
+    {
+        fprintf(out, "%ld", p->i);
+    }
+    else if (p->type == RESULTS_REAL)
+    {
+        fprintf(out, p->notation == 'e' ? "%.*e" : "%.*f", p->decimals, p->x);
+    }
+    else
+    {
+        fputs(p->text, out);
+    }
+    fprintf(out, "</%s>\n", tag);
+}
+
+void results_free_fields(results_field *fields, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        free(fields[i].text);
+        free(fields[i].values);
+        free(fields[i].part_sizes);
+    }
+    free(fields);
+}
@@ -0,0 +1,288 @@
+#ifndef RESULTS_H_
+#define RESULTS_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "writer.h"
+
+/** Formats of the output. */
+#define RESULTS_XML            0
+#define RESULTS_BINARY         1
+
+/** Version of the binary format, increased when it changes. */
+#define RESULTS_VERSION        2
+
+/** Types of values of the binary format. */
+#define RESULTS_INT            0
+#define RESULTS_REAL           1
+#define RESULTS_TEXT           2
+
+/** Kinds of markers in the text of the binary format. */
+#define RESULTS_PARAM          0
+#define RESULTS_COLUMN         1
+
+/** Maximum number of columns streamed while a simulation runs. */
+#define RESULTS_MAX_STREAMS    8
+
+/** Maximum length of the name of a column or a parameter. */
+#define RESULTS_NAME_LENGTH    64
+
+/** A parameter or a column (of the output, or of a file read back). */
+typedef struct
+{
+    char name[RESULTS_NAME_LENGTH]; /** The name, with its path. */
+
+    int type; /** RESULTS_INT, RESULTS_REAL or RESULTS_TEXT. */
+
+    char notation; /** How a real parameter is printed ('f' or 'e'). */
+
+    int decimals; /** Digits after the point of the reals. */
+
+    long i; /** Value of an int parameter. */
+
+    double x; /** Value of a real parameter. */
+
+    char *text; /** Value of a text parameter. */
+
+    int size; /** Number of values of a column. */
+
+    int capacity; /** Capacity of 'values' (in values). */
+
+    void *values; /** Values of a column, ints or doubles. */
+
+    int bytes; /** Bytes of a value in the file. */
+
+    bool loaded; /** True once the values and the sizes of the parts are in memory. */
+
+    int parts; /** Number of writes of a column. */
+
+    int parts_capacity; /** Capacity of 'part_sizes'. */
+
+    int *part_sizes; /** Number of values of each write. */
+
+    uint64_t offset; /** Offset of the values in the file. */
+
+    uint64_t parts_offset; /** Offset of the sizes of the parts in the file. */
+}
+results_field;
+
+/**
+ * Output of a simulation, as XML or in a compact binary format.
+ *
+ * The parameters are written with results_param_int, results_param_real
+ * and results_param_text, the arrays of numbers with results_ints and
+ * results_reals (results_int and results_real for one value), and the rest
+ * of the text (the reports of the modules) with fprintf on 'out'. A name
+ * can have a path ("vertex/id"): the XML element is the last part.
+ *
+ * In the binary format, the parameters are typed fields of the header and
+ * the arrays are columns: all the values written under a name, one after
+ * the other, with the size of each write (its parts, e.g. one per vertex).
+ * The text is kept with markers where the parameters and the parts go, so
+ * results_to_xml gives back exactly the XML output. The binary file is
+ * little-endian:
+ *
+ * - "ORIGRSLT", the version (uint32), 0x01020304 (uint32) and the state
+ *   (uint32): 1 once the simulation is done, 0 while it runs.
+ * - Done: the number of parameters and of columns (uint32 each), the offset
+ *   and the size of the text (uint64 each), then the parameters (the type,
+ *   the notation 'f' or 'e' and the number of decimals of a real, the length
+ *   of the name (uint8 each), the name, the value: int64, float64, or the
+ *   length (uint32) and the bytes of a text), then the directory of the
+ *   columns (the type, the bytes of a value, the decimals and the length of
+ *   the name (uint8 each), the name, the number of values and of parts
+ *   (uint32 each), the offset of the values and of the sizes of the parts
+ *   (uint64 each, 0 for the sizes if the parts have the same size)), then
+ *   the data, then the text. The values take the fewest bytes holding them
+ *   all exactly: ints on 1, 2 or 4 bytes, reals on 4 (float) or 8 (double).
+ *   A marker in the text is a 0 byte, the kind (uint8), the index of the
+ *   parameter or column (uint16) and the indentation (uint8).
+ * - Running: the series written with results_stream_ints, appended (and
+ *   flushed, or handed to the writer thread) at the end of every 1000
+ *   generations as chunks: the type and the length of the name (uint8
+ *   each), the name, the number of values (uint32) and the values. After a
+ *   crash the file holds the series up to the last 1000 generations;
+ *   results_close replaces them with the complete file.
+ */
+typedef struct
+{
+    FILE *out; /** Where the text is printed (in memory with the binary format). */
+
+    writer_file file; /** The file. */
+
+    writer *async; /** The thread writing the file (NULL to write it directly). */
+
+    char *filename; /** Name of the file (NULL to throw the output away). */
+
+    int format; /** RESULTS_XML or RESULTS_BINARY. */
+
+    char *text; /** The text of the binary format, with the markers. */
+
+    size_t text_size; /** Number of bytes of 'text'. */
+
+    int n_params; /** Number of parameters. */
+
+    int params_capacity; /** Capacity of 'params'. */
+
+    results_field *params; /** The parameters. */
+
+    int n_columns; /** Number of columns. */
+
+    int columns_capacity; /** Capacity of 'columns'. */
+
+    results_field *columns; /** The columns. */
+
+    int n_streams; /** Number of columns streamed. */
+
+    char streams[RESULTS_MAX_STREAMS][RESULTS_NAME_LENGTH]; /** Names of the columns streamed. */
+
+    int streamed[RESULTS_MAX_STREAMS]; /** Number of values already written for each column streamed. */
+}
+results;
+
+/** Open 'filename' for the output, written by 'async' if it isn't NULL, return false if it can't be created. */
+bool results_open(results *r, const char *filename, int format, writer *async);
+
+/** Write the parameter 'name', an integer, with 'indent' spaces before it. */
+void results_param_int(results *r, int indent, const char *name, long x);
+
+/** Write the parameter 'name', a real printed with 'decimals' digits in the 'notation' of printf ('f' or 'e'). */
+void results_param_real(results *r, int indent, const char *name, double x, char notation, int decimals);
+
+/** Write the parameter 'name', a text. */
+void results_param_text(results *r, int indent, const char *name, const char *x);
+
+/** Write the array 'x' of 'n' ints as the element 'name', with 'indent' spaces before it. */
+void results_ints(results *r, int indent, const char *name, const int *x, int n);
+
+/** Write the array 'x' of 'n' reals as the element 'name', with 'decimals' digits after the point. */
+void results_reals(results *r, int indent, const char *name, const double *x, int n, int decimals);
+
+/** Write one int as the element 'name' (a part of one value of the column). */
+void results_int(results *r, int indent, const char *name, int x);
+
+/** Write one real as the element 'name' (a part of one value of the column). */
+void results_real(results *r, int indent, const char *name, double x, int decimals);
+
+/**
+ * Write the values of 'x' not written yet for the column 'name' (the first
+ * 'n' values are known), in the binary format only. The last call of
+ * results_ints for 'name' gives the complete column.
+ */
+void results_stream_ints(results *r, const char *name, const int *x, int n);
+
+/** Write the complete file and close it. */
+void results_close(results *r);
+
+/** Extension of the files of a format. */
+const char *results_extension(int format);
+
+/**
+ * A binary file read back: the parameters and the directory of the columns
+ * come from the header, and the values of a column are only read (at its
+ * offset) when asked for. The file of a simulation that didn't finish only
+ * holds the streamed series, already read.
+ */
+typedef struct
+{
+    FILE *in; /** The file. */
+
+    bool complete; /** False for the file of a simulation that didn't finish. */
+
+    int n_params; /** Number of parameters. */
+
+    results_field *params; /** The parameters. */
+
+    int n_columns; /** Number of columns. */
+
+    results_field *columns; /** The directory of the columns. */
+
+    uint64_t text_offset; /** Offset of the text. */
+
+    uint64_t text_size; /** Size of the text. */
+}
+results_file;
+
+/** Read the header of a binary file, return false if it is missing or invalid. */
+bool results_file_open(results_file *rf, const char *filename);
+
+/** Return the parameter 'name' (NULL if there is none). */
+const results_field *results_file_param(const results_file *rf, const char *name);
+
+/** Return the column 'name' with its values and the sizes of its parts (NULL if there is none or it can't be read). */
+const results_field *results_file_column(results_file *rf, const char *name);
+
+/** Copy the 'size' values of a column to 'x', as ints. */
+void results_field_ints(const results_field *col, int *x);
+
+/** Copy the 'size' values of a column to 'x', as reals. */
+void results_field_reals(const results_field *col, double *x);
+
+/** Close the file and free the memory. */
+void results_file_close(results_file *rf);
+
+/** Write the XML of a binary file to 'out', return false if the file is missing, invalid, or didn't finish. */
+bool results_to_xml(const char *filename, FILE *out);
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions. You shouldn't need those.
+
+/** The XML element of 'name' (the part after the last '/'). */
+const char *results_tag(const char *name);
+
+/** Add a parameter to the output, and its marker to the text. */
+results_field *results_param(results *r, int indent, int type, const char *name);
+
+/** The column 'name' of the output, created if it doesn't exist. */
+results_field *results_column(results *r, int type, int decimals, const char *name);
+
+/** Add 'n' values to a column as one part, and its marker to the text. */
+void results_add_part(results *r, results_field *col, int indent, const void *x, int n);
+
+/** Add a marker to the text. */
+void results_marker(results *r, int kind, int index, int indent);
+
+/** Write the complete binary file. */
+void results_write(results *r, FILE *f);
+
+/** Fewest bytes holding every value of a column exactly. */
+int results_column_bytes(const results_field *col);
+
+/** True if the parts of a column all have the same size. */
+bool results_same_parts(const results_field *col);
+
+/** Put 'n' ints or doubles in 'buffer' in little-endian, on 'bytes' bytes each. */
+void results_put_values(unsigned char *buffer, int type, int bytes, const void *x, int n);
+
+/** Get 'n' ints or doubles of 'bytes' bytes each from 'buffer'. */
+void results_get_values(const unsigned char *buffer, int type, int bytes, void *x, int n);
+
+/** Append an unsigned integer of 'bytes' bytes in little-endian to a file. */
+void results_put_uint(FILE *out, int bytes, uint64_t x);
+
+/** Index of the column 'name' in 'streams' (-1 if it isn't streamed). */
+int results_stream_index(const results *r, const char *name);
+
+/** Read an unsigned integer of 'bytes' bytes in little-endian, return false at the end of the file. */
+bool results_get_uint(FILE *in, int bytes, uint64_t *x);
+
+/** Read a name of 'length' bytes, return false at the end of the file. */
+bool results_get_name(FILE *in, uint64_t length, char *name);
+
+/** Read the values of a column and the sizes of its parts. */
+bool results_file_load(results_file *rf, results_field *col);
+
+/** Read the streamed series of a file that didn't finish. */
+bool results_file_recover(results_file *rf);
+
+/** Print a part of a column as an XML element. */
+void results_print_part(const results_field *col, int first, int n, int indent, FILE *out);
+
+/** Print a parameter as an XML element. */
+void results_print_param(const results_field *p, int indent, FILE *out);
+
+/** Free the memory of fields. */
+void results_free_fields(results_field *fields, int n);
+
+#endif
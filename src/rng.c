@@ -0,0 +1,151 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <gsl/gsl_rng.h>
+#include "common.h"
+#include "rng.h"
+
+void rng_stream_init(rng_stream *r, int type, uint64_t seed)
+{
+    r->type = type;
+    r->gsl = NULL;
+    r->next = RNG_BUFFER_SIZE;
+    if (type == RNG_GSL)
+    {
+        r->gsl = gsl_rng_alloc(gsl_rng_taus2);
+        gsl_rng_set(r->gsl, (unsigned long)seed);
+    }
+    else if (type == RNG_PHILOX)
+    {
+        rng_stream_init_philox(r, (uint32_t)seed, (uint32_t)(seed >> 32), 0);
+    }
+    else
+    {
+        uint64_t x = seed;
+        for (int lane = 0; lane < RNG_LANES; ++lane)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                r->state[i][lane] = rng_splitmix64(&x);
+            }
+        }
+    }
+}
+
+void rng_stream_init_philox(rng_stream *r, uint32_t seed, uint32_t replicate, uint32_t substream)
+{
+    r->type = RNG_PHILOX;
+    r->gsl = NULL;
+    r->next = RNG_BUFFER_SIZE;
+    r->key[0] = seed;
+    r->key[1] = replicate;
+    r->substream = substream;
+    r->counter = 0;
+}
+
+const char *rng_stream_name(const rng_stream *r)
+{
+    switch (r->type)
+    {
+    case RNG_GSL:
+        return "GSL taus2";
+    case RNG_PHILOX:
+        return "Philox4x32-10";
+    default:
+        return "xoshiro256++";
+    }
+}
+
+void rng_stream_free(rng_stream *r)
+{
+    if (r->gsl != NULL)
+    {
+        gsl_rng_free(r->gsl);
+        r->gsl = NULL;
+    }
+}
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions
+
+uint64_t rng_splitmix64(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void rng_philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4])
+{
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; ++round)
+    {
+        rng_philox_round(&c0, &c1, &c2, &c3, k0, k1);
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+uint64_t rng_stream_refill(rng_stream *r)
+{
+    if (r->type == RNG_PHILOX)
+    {
+        // Each block of the counter gives two 64-bit words. The rounds are
+        // applied to all the blocks at once so the loop is vectorized.
+        enum { BLOCKS = RNG_BUFFER_SIZE / 2 };
+        uint32_t c0[BLOCKS], c1[BLOCKS], c2[BLOCKS], c3[BLOCKS];
+        for (int i = 0; i < BLOCKS; ++i)
+        {
+            const uint64_t block = r->counter + i;
+            c0[i] = (uint32_t)block;
+            c1[i] = (uint32_t)(block >> 32);
+            c2[i] = r->substream;
+            c3[i] = 0;
+        }
+        r->counter += BLOCKS;
+        uint32_t k0 = r->key[0];
+        uint32_t k1 = r->key[1];
+        for (int round = 0; round < 10; ++round)
+        {
+            for (int i = 0; i < BLOCKS; ++i)
+            {
+                rng_philox_round(&c0[i], &c1[i], &c2[i], &c3[i], k0, k1);
+            }
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+        for (int i = 0; i < BLOCKS; ++i)
+        {
+            r->buffer[2 * i] = ((uint64_t)c1[i] << 32) | c0[i];
+            r->buffer[2 * i + 1] = ((uint64_t)c3[i] << 32) | c2[i];
+        }
+        r->next = 1;
+        return r->buffer[0];
+    }
+    uint64_t *s0 = r->state[0];
+    uint64_t *s1 = r->state[1];
+    uint64_t *s2 = r->state[2];
+    uint64_t *s3 = r->state[3];
+    for (int i = 0; i < RNG_BUFFER_SIZE; i += RNG_LANES)
+    {
+        for (int lane = 0; lane < RNG_LANES; ++lane)
+        {
+            const uint64_t sum = s0[lane] + s3[lane];
+            r->buffer[i + lane] = ((sum << 23) | (sum >> 41)) + s0[lane];
+            const uint64_t t = s1[lane] << 17;
+            s2[lane] ^= s0[lane];
+            s3[lane] ^= s1[lane];
+            s1[lane] ^= s2[lane];
+            s0[lane] ^= s3[lane];
+            s2[lane] ^= t;
+            s3[lane] = (s3[lane] << 45) | (s3[lane] >> 19);
+        }
+    }
+    r->next = 1;
+    return r->buffer[0];
+}
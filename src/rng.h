@@ -0,0 +1,159 @@
+#ifndef RNG_H_
+#define RNG_H_
+
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <gsl/gsl_rng.h>
+
+/** GSL's Taus generator, one call per draw (same numbers as older versions). */
+#define RNG_GSL          0
+/** Four interleaved xoshiro256++ generators filling a buffer in blocks. */
+#define RNG_XOSHIRO      1
+/** Philox4x32-10, counter-based with independent substreams. */
+#define RNG_PHILOX       2
+
+/** Number of 64-bit words generated at once. */
+#ifndef RNG_BUFFER_SIZE
+#define RNG_BUFFER_SIZE  256
+#endif
+
+/** Number of interleaved xoshiro256++ generators (the lanes of the block). */
+#define RNG_LANES        4
+
+/**
+ * A stream of random numbers with a selectable backend.
+ *
+ * The xoshiro256++ backend runs RNG_LANES independent generators in
+ * lock-step (the loop is vectorized by the compiler) and buffers their
+ * output, so most draws are a load from the buffer. Uniform deviates and
+ * bounded integers are inlined in the callers.
+ *
+ * The Philox backend encrypts a counter with a key made of the seed and the
+ * replicate index; the substream index (e.g. a community) is part of the
+ * counter. The numbers of a substream depend only on (seed, replicate,
+ * substream), never on which thread draws them or when.
+ */
+typedef struct
+{
+    int type; /** Backend (RNG_GSL, RNG_XOSHIRO or RNG_PHILOX). */
+
+    gsl_rng *gsl; /** GSL generator (NULL for other backends). */
+
+    uint64_t state[4][RNG_LANES]; /** State of the xoshiro256++ generators. */
+
+    uint32_t key[2]; /** Philox key (seed, replicate). */
+
+    uint32_t substream; /** Philox substream. */
+
+    uint64_t counter; /** Number of Philox blocks generated in the substream. */
+
+    uint64_t buffer[RNG_BUFFER_SIZE]; /** Words not yet used. */
+
+    int next; /** Index of the next word in the buffer. */
+}
+rng_stream;
+
+/** Initialize the stream with a given backend and seed. */
+void rng_stream_init(rng_stream *r, int type, uint64_t seed);
+
+/**
+ * Initialize a Philox stream for a given seed, replicate and substream.
+ * Distinct (seed, replicate, substream) triplets give independent streams.
+ */
+void rng_stream_init_philox(rng_stream *r, uint32_t seed, uint32_t replicate, uint32_t substream);
+
+/** Name of the backend (for the output). */
+const char *rng_stream_name(const rng_stream *r);
+
+/** Free the memory. */
+void rng_stream_free(rng_stream *r);
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions. You shouldn't need those.
+
+/** SplitMix64, used to expand a seed into the states of the generators. */
+uint64_t rng_splitmix64(uint64_t *x);
+
+/** Philox4x32-10: encrypt the counter 'ctr' with 'key' and store the result in 'out'. */
+void rng_philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]);
+
+/** One round of Philox4x32 on the counter (c0, c1, c2, c3) with the round key (k0, k1). */
+static inline void rng_philox_round(uint32_t *c0, uint32_t *c1, uint32_t *c2, uint32_t *c3, uint32_t k0, uint32_t k1)
+{
+    const uint64_t p0 = (uint64_t)0xD2511F53 * *c0;
+    const uint64_t p1 = (uint64_t)0xCD9E8D57 * *c2;
+    *c0 = (uint32_t)(p1 >> 32) ^ *c1 ^ k0;
+    *c1 = (uint32_t)p1;
+    *c2 = (uint32_t)(p0 >> 32) ^ *c3 ^ k1;
+    *c3 = (uint32_t)p0;
+}
+
+/** Fill the buffer and return its first word. */
+uint64_t rng_stream_refill(rng_stream *r);
+
+/** Return the next 64-bit word (xoshiro and Philox backends). */
+static inline uint64_t rng_stream_next(rng_stream *r)
+{
+    return r->next < RNG_BUFFER_SIZE ? r->buffer[r->next++] : rng_stream_refill(r);
+}
+
+///////////////////////////////////////////////////////////////
+// Draws (defined here so they are inlined in the hot loops)
+
+/** Return a uniform double in [0, 1). */
+static inline double rng_stream_uniform(rng_stream *r)
+{
+    if (r->type == RNG_GSL)
+    {
+        return gsl_rng_uniform(r->gsl);
+    }
+    return (rng_stream_next(r) >> 11) * (1.0 / 9007199254740992.0); // 53 bits / 2^53
+}
+
+/**
+ * Return a uniform integer in [0, n) for 0 < n < 2^32. Lemire's multiply
+ * and reject method for xoshiro and Philox; (int)(uniform * n) for GSL, as
+ * in older versions.
+ */
+static inline int rng_stream_bounded(rng_stream *r, uint32_t n)
+{
+    if (r->type == RNG_GSL)
+    {
+        return (int)(gsl_rng_uniform(r->gsl) * n);
+    }
+    uint64_t m = (rng_stream_next(r) >> 32) * (uint64_t)n;
+    uint32_t low = (uint32_t)m;
+    if (low < n)
+    {
+        const uint32_t threshold = -n % n;
+        while (low < threshold)
+        {
+            m = (rng_stream_next(r) >> 32) * (uint64_t)n;
+            low = (uint32_t)m;
+        }
+    }
+    return (int)(m >> 32);
+}
+
+/**
+ * Return the number of Bernoulli trials of probability 'p' up to and
+ * including the first success (at least 1), by inversion, or 0 when 'p' is
+ * 0 (no success ever). The count is 64-bit so a tiny 'p' keeps the tail of
+ * its distribution (it is only capped at INT64_MAX).
+ */
+static inline int64_t rng_stream_geometric(rng_stream *r, double p)
+{
+    if (p <= 0.0)
+    {
+        return 0;
+    }
+    if (p >= 1.0)
+    {
+        return 1;
+    }
+    const double trials = floor(log(1.0 - rng_stream_uniform(r)) / log1p(-p));
+    return trials >= (double)INT64_MAX ? INT64_MAX : 1 + (int64_t)trials;
+}
+
+#endif
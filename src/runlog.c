@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "utils.h"
+#include "runlog.h"
+
+bool runlog_open(runlog *log, const char *filename, int jobs, int threads)
+{
+    log->out = NULL;
+    log->close = false;
+    log->start = seconds_monotonic();
+    pthread_mutex_init(&log->lock, NULL);
+    if (filename == NULL)
+    {
+        return true;
+    }
+    if (strcmp(filename, "-") == 0)
+    {
+        log->out = stderr;
+    }
+    else
+    {
+        log->out = fopen(filename, "w");
+        log->close = log->out != NULL;
+    }
+    if (log->out == NULL)
+    {
+        return false;
+    }
+    runlog_write(log, "run", "jobs=\"%d\" threads=\"%d\"", jobs, threads);
+    return true;
+}
+
+void runlog_write(runlog *log, const char *type, const char *format, ...)
+{
+    if (log == NULL || log->out == NULL)
+    {
+        return;
+    }
+    char record[RUNLOG_RECORD_LENGTH];
+    int n = snprintf(record, RUNLOG_RECORD_LENGTH, "<%s t=\"%.3f\" ", type, seconds_monotonic() - log->start);
+    va_list args;
+    va_start(args, format);
+    n += vsnprintf(record + n, RUNLOG_RECORD_LENGTH - n, format, args);
+    va_end(args);
+    if (n > RUNLOG_RECORD_LENGTH - 4)
+    {
+        n = RUNLOG_RECORD_LENGTH - 4;
+    }
+    memcpy(record + n, "/>\n", 4);
+
+    // One write per record:
+    pthread_mutex_lock(&log->lock);
+    fputs(record, log->out);
+    fflush(log->out);
+    pthread_mutex_unlock(&log->lock);
+}
+
+void runlog_close(runlog *log)
+{
+    runlog_write(log, "done", "seconds=\"%.3f\"", seconds_monotonic() - log->start);
+    if (log->close)
+    {
+        fclose(log->out);
+    }
+    pthread_mutex_destroy(&log->lock);
+}
+
+void runlog_sim_start(runlog_sim *rs, runlog *log, int point, int replicate, unsigned int seed, int k_gen, int k_start, double events_per_k)
+{
+    rs->log = log;
+    rs->point = point;
+    rs->replicate = replicate;
+    rs->seed = seed;
+    rs->k_gen = k_gen;
+    rs->k_start = k_start;
+    rs->events_per_k = events_per_k;
+    rs->start = seconds_monotonic();
+    rs->last = rs->start;
+    runlog_write(log, "start", "point=\"%d\" replicate=\"%d\" seed=\"%u\" k_gen=\"%d\" first_k=\"%d\"", point, replicate, seed, k_gen, k_start);
+}
+
+void runlog_sim_progress(runlog_sim *rs, int k, int richness)
+{
+    if (rs->log == NULL || rs->log->out == NULL)
+    {
+        return;
+    }
+    const double now = seconds_monotonic();
+    const double seconds = now - rs->last;
+    // The mean time per group so far, for the groups left:
+    const double eta = (now - rs->start) / (k + 1 - rs->k_start) * (rs->k_gen - k - 1);
+    rs->last = now;
+    runlog_write(rs->log, "progress", "point=\"%d\" replicate=\"%d\" seed=\"%u\" k=\"%d\" k_gen=\"%d\" generations=\"%d\" events_per_second=\"%.3g\" richness=\"%d\" eta_seconds=\"%.1f\"",
+                 rs->point, rs->replicate, rs->seed, k + 1, rs->k_gen, (k + 1) * 1000, seconds > 0.0 ? rs->events_per_k / seconds : 0.0, richness, eta);
+}
+
+void runlog_sim_end(runlog_sim *rs, int k_done, int richness)
+{
+    const double seconds = seconds_monotonic() - rs->start;
+    runlog_write(rs->log, "end", "point=\"%d\" replicate=\"%d\" seed=\"%u\" k=\"%d\" richness=\"%d\" seconds=\"%.3f\" events_per_second=\"%.3g\"",
+                 rs->point, rs->replicate, rs->seed, k_done, richness, seconds, seconds > 0.0 ? rs->events_per_k * (k_done - rs->k_start) / seconds : 0.0);
+}
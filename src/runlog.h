@@ -0,0 +1,77 @@
+#ifndef RUNLOG_H_
+#define RUNLOG_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/** Maximum length of a record. */
+#define RUNLOG_RECORD_LENGTH   512
+
+/**
+ * A log of the run, shared by all the threads: one record per line, an
+ * empty XML element whose attributes are the values, e.g.
+ *
+ *   <progress t="12.031" point="-1" replicate="3" seed="8" k="5" k_gen="100"
+ *             generations="5000" events_per_second="2.41e+07" richness="42"
+ *             eta_seconds="230.4"/>
+ *
+ * Each record is formatted by its thread first, then written and flushed
+ * in one call while holding the lock, so the records never mix and the
+ * file can be followed (tail -f) while the simulations run. 't' is the
+ * number of seconds since the log was opened.
+ */
+typedef struct
+{
+    FILE *out; /** The log (NULL if there is none). */
+
+    bool close; /** True if the file must be closed at the end (not stderr). */
+
+    pthread_mutex_t lock; /** Protects 'out'. */
+
+    double start; /** When the log was opened. */
+}
+runlog;
+
+/** The progress of one simulation, written to a log. */
+typedef struct
+{
+    runlog *log; /** The log (NULL to log nothing). */
+
+    int point; /** Point of the sweep (-1 without a sweep). */
+
+    int replicate; /** Index of the simulation. */
+
+    unsigned int seed; /** Seed of the simulation. */
+
+    int k_gen; /** Number of groups of 1000 generations to run. */
+
+    int k_start; /** First group run (after a checkpoint or the burn-in). */
+
+    double events_per_k; /** Replacements per group of 1000 generations. */
+
+    double start; /** When the simulation started. */
+
+    double last; /** When the last group ended. */
+}
+runlog_sim;
+
+/** Open the log ("-" for the standard error, NULL for no log) and write the first record. */
+bool runlog_open(runlog *log, const char *filename, int jobs, int threads);
+
+/** Write a record (a printf format for the attributes, after the time). */
+void runlog_write(runlog *log, const char *type, const char *format, ...);
+
+/** Write the last record and close the log. */
+void runlog_close(runlog *log);
+
+/** Start logging a simulation ('log' can be NULL). */
+void runlog_sim_start(runlog_sim *rs, runlog *log, int point, int replicate, unsigned int seed, int k_gen, int k_start, double events_per_k);
+
+/** Log the end of the group 'k' of a simulation, with the number of species. */
+void runlog_sim_progress(runlog_sim *rs, int k, int richness);
+
+/** Log the end of a simulation, after 'k_done' groups of 1000 generations. */
+void runlog_sim_end(runlog_sim *rs, int k_done, int richness);
+
+#endif
@@ -16,6 +16,9 @@ species *species_init(int subpopulations, int time_of_birth, int n_genotypes)
     temp->subpops = subpopulations;
     temp->n_genotypes = n_genotypes;
     temp->birth = time_of_birth;
+    temp->slot = -1;
+    temp->node = NULL;
+    temp->total = 0;
 
     temp->n = (int*)malloc(subpopulations * sizeof(int));
     for (int i = 0; i < subpopulations; ++i)
@@ -36,26 +39,12 @@ species *species_init(int subpopulations, int time_of_birth, int n_genotypes)
 
 ORIGIN_INLINE bool species_is_extant(const species *s)
 {
-    for (int i = 0; i < s->subpops; ++i)
-    {
-        if (s->n[i] > 0)
-        {
-            return true;
-        }
-    }
-    return false;
+    return s->total > 0;
 }
 
 ORIGIN_INLINE bool species_is_extinct(const species *s)
 {
-    for (int i = 0; i < s->subpops; ++i)
-    {
-        if (s->n[i] > 0)
-        {
-            return false; 
-        }
-    }
-    return true;
+    return s->total == 0;
 }
 
 ORIGIN_INLINE int species_total(const species *s)
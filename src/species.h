@@ -3,6 +3,8 @@
 
 #include <stdbool.h>
 
+struct slnode_;
+
 /** An array of ints for individuals in different subpopulations. */
 typedef struct
 {
@@ -18,8 +20,17 @@ typedef struct
     /** Number of individual of each genotype per subpopulations. */
     int **genotypes;
         
+    /** Total number of individuals (the sum of 'n'), kept up to date with 'n'. */
+    int total;
+
     /** Date of birth. */
     int birth;
+
+    /** Slot in an abundance index (-1 if not indexed). */
+    int slot;
+
+    /** Node of the species_list holding the species (NULL if none). */
+    struct slnode_ *node;
 }
 species;
 
@@ -32,7 +43,7 @@ bool species_is_extant(const species *pop);
 /** Return true if the population is extinct. */
 bool species_is_extinct(const species *pop);
 
-/** Return the total population. */
+/** Return the total population (the sum of 'n', which must match 'total'). */
 int species_total(const species *pop);
 
 /** Free the memory. */
@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include "common.h"
+#include "fenwick.h"
+#include "species.h"
+#include "specieslist.h"
+#include "speciesindex.h"
+
+void species_index_init(species_index *si, const species_list *list, int communities)
+{
+    fenwick_init(&si->f, communities, 2 * list->size);
+    si->slots = NULL;
+    species_index_rebuild(si, list);
+}
+
+ORIGIN_INLINE void species_index_add(species_index *si, const species_list *list, species *sp)
+{
+    if (si->next == si->f.capacity)
+    {
+        // No slot left: compact (and grow if needed) the slots.
+        species_index_rebuild(si, list);
+        return;
+    }
+    sp->slot = si->next++;
+    si->slots[sp->slot] = sp;
+    for (int c = 0; c < si->f.communities; ++c)
+    {
+        if (sp->n[c] != 0)
+        {
+            fenwick_add(&si->f, c, sp->slot, sp->n[c]);
+        }
+    }
+}
+
+ORIGIN_INLINE void species_index_update(species_index *si, const species *sp, int c, int delta)
+{
+    fenwick_add(&si->f, c, sp->slot, delta);
+}
+
+ORIGIN_INLINE species *species_index_find(const species_index *si, int c, int position)
+{
+    return si->slots[fenwick_find(&si->f, c, position)];
+}
+
+void species_index_free(species_index *si)
+{
+    fenwick_free(&si->f);
+    free(si->slots);
+    si->slots = NULL;
+}
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions
+
+void species_index_rebuild(species_index *si, const species_list *list)
+{
+    // Keep at least half of the slots free to amortize the rebuilds:
+    const int old_capacity = si->f.capacity;
+    fenwick_reset(&si->f, 2 * list->size);
+    if (si->slots == NULL || si->f.capacity != old_capacity)
+    {
+        free(si->slots);
+        si->slots = (species**)malloc(si->f.capacity * sizeof(species*));
+    }
+    const int communities = si->f.communities;
+    const int capacity = si->f.capacity;
+    int slot = 0;
+    for (slnode *it = list->head; it != NULL; it = it->next, ++slot)
+    {
+        it->sp->slot = slot;
+        si->slots[slot] = it->sp;
+        for (int c = 0; c < communities; ++c)
+        {
+            si->f.tree[(size_t)c * capacity + slot] = it->sp->n[c];
+        }
+    }
+    si->next = slot;
+    for (int c = 0; c < communities; ++c)
+    {
+        fenwick_build(&si->f, c);
+    }
+}
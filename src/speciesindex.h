@@ -0,0 +1,48 @@
+#ifndef SPECIESINDEX_H_
+#define SPECIESINDEX_H_
+
+#include "fenwick.h"
+#include "species.h"
+#include "specieslist.h"
+
+/**
+ * Index of the abundances of a species_list in every community, used to
+ * pick a random individual in \f$O(\log S)\f$ instead of walking the list.
+ *
+ * Species get slots in the order of the list, so for the same uniform
+ * position the index returns the same species as a walk from the head of
+ * the list. Slots of extinct species keep an abundance of 0 and are never
+ * returned; they are reclaimed when the slots are compacted.
+ */
+typedef struct
+{
+    fenwick f; /** Cumulative abundances of the slots. */
+
+    species **slots; /** Species stored in each slot. */
+
+    int next; /** First unused slot. */
+}
+species_index;
+
+/** Initialize the index with all the species of the list. */
+void species_index_init(species_index *si, const species_list *list, int communities);
+
+/** Give a slot to 'sp' (which must be the tail of 'list') and index its abundances. */
+void species_index_add(species_index *si, const species_list *list, species *sp);
+
+/** Add 'delta' to the abundance of the species in community 'c'. Call it every time 'sp->n[c]' changes. */
+void species_index_update(species_index *si, const species *sp, int c, int delta);
+
+/** Return the species of the individual at 'position' (0 <= position < number of individuals in 'c'). */
+species *species_index_find(const species_index *si, int c, int position);
+
+/** Free the memory of the struct. */
+void species_index_free(species_index *si);
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions. You shouldn't need those.
+
+/** Give new slots to the species of the list (in order) and rebuild the trees. */
+void species_index_rebuild(species_index *si, const species_list *list);
+
+#endif
@@ -10,6 +10,7 @@
 #include "specieslist.h"
 #include "ivector.h"
 #include "species.h"
+#include "speciespool.h"
 
 ORIGIN_INLINE species_list *species_list_init()
 {
@@ -18,6 +19,10 @@ ORIGIN_INLINE species_list *species_list_init()
     temp->size = 0;
     temp->head = NULL;
     temp->tail = NULL;
+    temp->pool = NULL;
+    temp->dead = NULL;
+    temp->pending = 0;
+    temp->dead_capacity = 0;
 
     return temp;
 }
@@ -25,25 +30,38 @@ ORIGIN_INLINE species_list *species_list_init()
 // Always add the species at the end;
 ORIGIN_INLINE void species_list_add(species_list *list, species *s)
 {
-    // Create the slnode object to contain the species
-    slnode *new_node = (slnode*)malloc(sizeof(slnode));
+    // Create the slnode object to contain the species (the pool stores it with the species)
+    slnode *new_node = list->pool != NULL ? species_pool_node(s) : (slnode*)malloc(sizeof(slnode));
     new_node->sp = s;
     new_node->next = NULL;
+    s->node = new_node;
 
     // No species in the list;
     if (list->size == 0)
     {
+        new_node->prev = NULL;
         list->head = new_node;
         list->tail = new_node;
     }
     else
     {
+        new_node->prev = list->tail;
         list->tail->next = new_node;
         list->tail = new_node;
     }
     list->size++;
 }
 
+ORIGIN_INLINE void species_list_add_pending(species_list *list, species *s)
+{
+    if (list->pending == list->dead_capacity)
+    {
+        list->dead_capacity = list->dead_capacity > 0 ? 2 * list->dead_capacity : VECTOR_INIT_CAPACITY;
+        list->dead = (slnode**)realloc(list->dead, list->dead_capacity * sizeof(slnode*));
+    }
+    list->dead[list->pending++] = s->node;
+}
+
 ORIGIN_INLINE bool species_list_rmv_next(species_list *list, slnode *node)
 {
     slnode *old_node;
@@ -57,6 +75,10 @@ ORIGIN_INLINE bool species_list_rmv_next(species_list *list, slnode *node)
     {
         old_node = list->head;
         list->head = list->head->next;
+        if (list->head != NULL)
+        {
+            list->head->prev = NULL;
+        }
     }
     else
     {
@@ -72,9 +94,20 @@ ORIGIN_INLINE bool species_list_rmv_next(species_list *list, slnode *node)
         {
             list->tail = node;
         }
+        else
+        {
+            node->next->prev = node;
+        }
+    }
+    if (list->pool != NULL)
+    {
+        species_pool_release(list->pool, old_node->sp);
+    }
+    else
+    {
+        species_free(old_node->sp);
+        free(old_node);
     }
-    species_free(old_node->sp);
-    free(old_node);
 
     list->size--;
     return true;
@@ -89,12 +122,13 @@ ORIGIN_INLINE int species_list_rmv_extinct(species_list *list)
     int extinctions = 0; // Number of extinctions
     slnode *node = list->head;
 
-    while (species_is_extant(node->sp) == false)
+    while (node != NULL && species_is_extant(node->sp) == false)
     {
         species_list_rmv_next(list, NULL);
+        ++extinctions;
         node = list->head;
     }
-    while (node->next != NULL)
+    while (node != NULL && node->next != NULL)
     {
         if (species_is_extant(node->next->sp) == false)
         {
@@ -118,14 +152,14 @@ ORIGIN_INLINE int species_list_rmv_extinct2(species_list *list, ivector *lifespa
     int extinctions = 0; // Number of extinctions
     slnode *node = list->head;
 
-    while (species_is_extant(node->sp) == false)
+    while (node != NULL && species_is_extant(node->sp) == false)
     {
-        ivector_add(lifespan, date - node->next->sp->birth);
+        ivector_add(lifespan, date - node->sp->birth);
         species_list_rmv_next(list, NULL);
         ++extinctions;
         node = list->head;
     }
-    while (node->next != NULL)
+    while (node != NULL && node->next != NULL)
     {
         if (species_is_extant(node->next->sp) == false)
         {
@@ -141,6 +175,19 @@ ORIGIN_INLINE int species_list_rmv_extinct2(species_list *list, ivector *lifespa
     return extinctions;
 }
 
+ORIGIN_INLINE int species_list_rmv_pending(species_list *list, ivector *lifespan, int date)
+{
+    const int extinctions = list->pending;
+    for (int i = 0; i < extinctions; ++i)
+    {
+        slnode *node = list->dead[i];
+        ivector_add(lifespan, date - node->sp->birth);
+        species_list_rmv_next(list, node->prev);
+    }
+    list->pending = 0;
+    return extinctions;
+}
+
 ORIGIN_INLINE slnode *species_list_get(species_list *list, int n)
 {
     if (n < 0 || n >= list->size)
@@ -189,5 +236,6 @@ ORIGIN_INLINE void species_list_print_pop(species_list *list, FILE *out)
 ORIGIN_INLINE void species_list_free(species_list *list)
 {
     while (species_list_rmv_next(list, NULL));
+    free(list->dead);
     free(list);
 }
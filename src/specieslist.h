@@ -8,12 +8,16 @@
 #include "ivector.h"
 #include "species.h"
 
-/** A node of the singly-linked list. */
+struct species_pool_;
+
+/** A node of the doubly-linked list. */
 typedef struct slnode_
 {
     species *sp; /** The species. */
 
     struct slnode_ *next; /** Pointer to the next node. */
+
+    struct slnode_ *prev; /** Pointer to the previous node. */
 }
 slnode;
 
@@ -28,15 +32,30 @@ typedef struct
 
     /** Last element of the list. */
     slnode *tail;
+
+    /** Allocator of the species and nodes (NULL for malloc/free). */
+    struct species_pool_ *pool;
+
+    /** Nodes of the species whose total dropped to 0 since the last call to species_list_rmv_pending. */
+    slnode **dead;
+
+    /** Number of nodes in 'dead'. */
+    int pending;
+
+    /** Size of 'dead'. */
+    int dead_capacity;
 }
 species_list;
 
 /** Initialize the list. */
 species_list *species_list_init();
 
-/** Insert a new species at the end of the list. */
+/** Insert a new species at the end of the list. With a pool, the species must come from species_pool_species. */
 void species_list_add(species_list *list, species *s);
 
+/** Queue a species of the list whose total dropped to 0 (it must be queued once). \f$O(1)\f$. */
+void species_list_add_pending(species_list *list, species *s);
+
 /** Remove the node next to the supplied node. If 'NULL', remove the head of the list. Return 'true' if a node was removed. */
 bool species_list_rmv_next(species_list *list, slnode *node);
 
@@ -46,6 +65,14 @@ int species_list_rmv_extinct(species_list *list);
 /** Remove extinct species from the list, add the lifespan of the extinct species to the vector, and return the number of extinctions. */
 int species_list_rmv_extinct2(species_list *list, ivector *lifespan, int date);
 
+/**
+ * Remove the queued extinct species from the list, add their lifespan to the
+ * vector, and return the number of extinctions. Each node is unlinked in
+ * constant time, so the cost depends on the extinctions, not on the size of
+ * the list.
+ */
+int species_list_rmv_pending(species_list *list, ivector *lifespan, int date);
+
 /** Return a pointer to the 'nth' node. */
 slnode *species_list_get(species_list *list, int n);
 
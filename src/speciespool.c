@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include "common.h"
+#include "species.h"
+#include "specieslist.h"
+#include "speciespool.h"
+
+void species_pool_init(species_pool *pool, int communities, int n_genotypes, int initial)
+{
+    pool->communities = communities;
+    pool->n_genotypes = n_genotypes;
+    // The record, the array of pointers to the genotypes, then the ints,
+    // rounded up so the next record is aligned:
+    const size_t align = sizeof(void*) > sizeof(double) ? sizeof(void*) : sizeof(double);
+    size_t size = sizeof(species_record) + n_genotypes * sizeof(int*) + (size_t)communities * (1 + n_genotypes) * sizeof(int);
+    pool->record_size = (size + align - 1) / align * align;
+    pool->slabs = NULL;
+    pool->n_slabs = 0;
+    pool->next_capacity = initial < SPECIES_POOL_MIN_RECORDS ? SPECIES_POOL_MIN_RECORDS : initial;
+    pool->cursor = NULL;
+    pool->end = NULL;
+    pool->free_records = NULL;
+    pool->live = 0;
+    pool->peak = 0;
+    pool->growths = -1;
+    pool->capacity = 0;
+    species_pool_grow(pool);
+}
+
+species *species_pool_species(species_pool *pool, int time_of_birth)
+{
+    species_record *record;
+    if (pool->free_records != NULL)
+    {
+        record = pool->free_records;
+        pool->free_records = (species_record*)record->node.next;
+    }
+    else
+    {
+        if (pool->cursor == pool->end)
+        {
+            species_pool_grow(pool);
+        }
+        record = (species_record*)pool->cursor;
+        pool->cursor += pool->record_size;
+    }
+    if (++pool->live > pool->peak)
+    {
+        pool->peak = pool->live;
+    }
+    const int communities = pool->communities;
+    species *sp = &record->sp;
+    int **genotypes = (int**)(record + 1);
+    int *counts = (int*)(genotypes + pool->n_genotypes);
+    memset(counts, 0, (size_t)communities * (1 + pool->n_genotypes) * sizeof(int));
+
+    record->node.sp = sp;
+    record->node.next = NULL;
+    record->node.prev = NULL;
+    sp->subpops = communities;
+    sp->n_genotypes = pool->n_genotypes;
+    sp->birth = time_of_birth;
+    sp->slot = -1;
+    sp->node = NULL;
+    sp->total = 0;
+    sp->n = counts;
+    sp->genotypes = genotypes;
+    for (int i = 0; i < pool->n_genotypes; ++i)
+    {
+        genotypes[i] = counts + (size_t)(1 + i) * communities;
+    }
+    return sp;
+}
+
+ORIGIN_INLINE slnode *species_pool_node(species *sp)
+{
+    return (slnode*)((char*)sp - offsetof(species_record, sp) + offsetof(species_record, node));
+}
+
+ORIGIN_INLINE void species_pool_release(species_pool *pool, species *sp)
+{
+    species_record *record = (species_record*)((char*)sp - offsetof(species_record, sp));
+    record->node.next = (slnode*)pool->free_records;
+    pool->free_records = record;
+    pool->live--;
+}
+
+void species_pool_reserve(species_pool *pool, int records)
+{
+    while (pool->capacity < records)
+    {
+        // The records left in the last slab go on the free list, so none is lost:
+        while (pool->cursor != pool->end)
+        {
+            species_record *record = (species_record*)pool->cursor;
+            record->node.next = (slnode*)pool->free_records;
+            pool->free_records = record;
+            pool->cursor += pool->record_size;
+        }
+        species_pool_grow(pool);
+    }
+    if (records > pool->peak)
+    {
+        pool->peak = records;
+    }
+}
+
+void species_pool_print(const species_pool *pool, FILE *out)
+{
+    fprintf(out, "  <species_pool>\n");
+    fprintf(out, "    <record_bytes>%lu</record_bytes>\n", (unsigned long)pool->record_size);
+    fprintf(out, "    <peak_live_species>%d</peak_live_species>\n", pool->peak);
+    fprintf(out, "    <slabs>%d</slabs>\n", pool->n_slabs);
+    fprintf(out, "    <slab_growths>%d</slab_growths>\n", pool->growths);
+    fprintf(out, "  </species_pool>\n");
+}
+
+void species_pool_free(species_pool *pool)
+{
+    for (int i = 0; i < pool->n_slabs; ++i)
+    {
+        free(pool->slabs[i]);
+    }
+    free(pool->slabs);
+}
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions
+
+void species_pool_grow(species_pool *pool)
+{
+    pool->slabs = (char**)realloc(pool->slabs, (pool->n_slabs + 1) * sizeof(char*));
+    char *slab = (char*)malloc(pool->next_capacity * pool->record_size);
+    pool->slabs[pool->n_slabs++] = slab;
+    pool->cursor = slab;
+    pool->end = slab + pool->next_capacity * pool->record_size;
+    pool->capacity += pool->next_capacity;
+    pool->next_capacity *= VECTOR_GROW_RATE;
+    pool->growths++;
+}
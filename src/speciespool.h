@@ -0,0 +1,95 @@
+#ifndef SPECIESPOOL_H_
+#define SPECIESPOOL_H_
+
+#include <stddef.h>
+#include <stdio.h>
+#include "species.h"
+#include "specieslist.h"
+
+/** Minimum number of records in the first slab. */
+#define SPECIES_POOL_MIN_RECORDS    16
+
+/**
+ * A species and the node of the list holding it, allocated as one record
+ * with the arrays of the species ('genotypes', 'n' and the counts of each
+ * genotype) right after it.
+ */
+typedef struct
+{
+    slnode node; /** The node of the list ('node.next' links the free records). */
+
+    species sp; /** The species. */
+}
+species_record;
+
+/**
+ * Slab allocator for the species of one simulation. Records have the same
+ * size (computed from the number of communities and genotypes) and are
+ * carved from slabs, each one twice as large as the previous one. Records of
+ * extinct species go on a free list and are recycled by the next
+ * speciation, so a long run stops calling malloc/free once the largest
+ * number of species has been reached. Not thread-safe: use one pool per
+ * simulation.
+ */
+typedef struct species_pool_
+{
+    int communities; /** Number of communities of the species. */
+
+    int n_genotypes; /** Number of genotypes of the species. */
+
+    size_t record_size; /** Size of a record and its arrays, in bytes. */
+
+    char **slabs; /** The slabs. */
+
+    int n_slabs; /** Number of slabs. */
+
+    int next_capacity; /** Number of records of the next slab. */
+
+    char *cursor; /** Next unused record in the last slab. */
+
+    char *end; /** End of the last slab. */
+
+    species_record *free_records; /** Recycled records. */
+
+    int live; /** Number of species in use. */
+
+    int peak; /** Largest number of species in use. */
+
+    int growths; /** Number of slabs added after the first one. */
+
+    int capacity; /** Number of records in all the slabs. */
+}
+species_pool;
+
+/** Initialize the pool with a first slab of 'initial' records (at least SPECIES_POOL_MIN_RECORDS). */
+void species_pool_init(species_pool *pool, int communities, int n_genotypes, int initial);
+
+/** Return a species with no individuals, like species_init. */
+species *species_pool_species(species_pool *pool, int time_of_birth);
+
+/** Return the node of the list stored with a species of the pool. */
+slnode *species_pool_node(species *sp);
+
+/** Give back the record of a species (and its node) for recycling. */
+void species_pool_release(species_pool *pool, species *sp);
+
+/**
+ * Add slabs until they hold 'records' records and raise the peak to
+ * 'records', as if that many species had been in use at once (to resume a
+ * simulation with the pool it had).
+ */
+void species_pool_reserve(species_pool *pool, int records);
+
+/** Print the statistics of the pool. */
+void species_pool_print(const species_pool *pool, FILE *out);
+
+/** Free the memory of the struct (and every species in it). */
+void species_pool_free(species_pool *pool);
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions. You shouldn't need those.
+
+/** Add a slab of 'next_capacity' records. */
+void species_pool_grow(species_pool *pool);
+
+#endif
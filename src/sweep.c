@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include "common.h"
+#include "sweep.h"
+
+void sweep_init(sweep *sw)
+{
+    sw->capacity = VECTOR_INIT_CAPACITY;
+    sw->options = (char***)malloc(sw->capacity * sizeof(char**));
+    sw->n_options = (int*)malloc(sw->capacity * sizeof(int));
+    sw->n_points = 0;
+}
+
+bool sweep_read_grid(sweep *sw, const char *filename)
+{
+    FILE *in = fopen(filename, "r");
+    if (in == NULL)
+    {
+        return false;
+    }
+    // The values of each parameter, in the form -name=value:
+    int dims = 0;
+    int dims_capacity = VECTOR_INIT_CAPACITY;
+    char ***values = (char***)malloc(dims_capacity * sizeof(char**));
+    int *n_values = (int*)malloc(dims_capacity * sizeof(int));
+    bool ok = true;
+
+    char line[SWEEP_LINE_LENGTH];
+    char *tokens[SWEEP_MAX_TOKENS];
+    while (ok && fgets(line, SWEEP_LINE_LENGTH, in) != NULL)
+    {
+        const int n = sweep_split(line, tokens);
+        if (n == 0)
+        {
+            continue;
+        }
+        if (dims == dims_capacity)
+        {
+            dims_capacity *= VECTOR_GROW_RATE;
+            values = (char***)realloc(values, dims_capacity * sizeof(char**));
+            n_values = (int*)realloc(n_values, dims_capacity * sizeof(int));
+        }
+        values[dims] = (char**)malloc(SWEEP_MAX_TOKENS * sizeof(char*));
+        n_values[dims] = 0;
+        for (int i = 1; ok && i < n; ++i)
+        {
+            ok = sweep_expand(tokens[0], tokens[i], values[dims], &n_values[dims]);
+        }
+        if (n_values[dims] == 0)
+        {
+            ok = false;
+        }
+        ++dims;
+    }
+    fclose(in);
+
+    if (ok && dims > 0)
+    {
+        // All the combinations, the last parameter varying the fastest:
+        int *digit = (int*)calloc(dims, sizeof(int));
+        char **point = (char**)malloc(dims * sizeof(char*));
+        bool done = false;
+        while (!done)
+        {
+            for (int d = 0; d < dims; ++d)
+            {
+                point[d] = values[d][digit[d]];
+            }
+            sweep_add_point(sw, point, dims);
+            done = true;
+            for (int d = dims - 1; d >= 0; --d)
+            {
+                if (++digit[d] < n_values[d])
+                {
+                    done = false;
+                    break;
+                }
+                digit[d] = 0;
+            }
+        }
+        free(digit);
+        free(point);
+    }
+
+    for (int d = 0; d < dims; ++d)
+    {
+        for (int i = 0; i < n_values[d]; ++i)
+        {
+            free(values[d][i]);
+        }
+        free(values[d]);
+    }
+    free(values);
+    free(n_values);
+    return ok;
+}
+
+bool sweep_read_jobs(sweep *sw, const char *filename)
+{
+    FILE *in = fopen(filename, "r");
+    if (in == NULL)
+    {
+        return false;
+    }
+    char line[SWEEP_LINE_LENGTH];
+    char *tokens[SWEEP_MAX_TOKENS];
+    while (fgets(line, SWEEP_LINE_LENGTH, in) != NULL)
+    {
+        const int n = sweep_split(line, tokens);
+        if (n > 0)
+        {
+            sweep_add_point(sw, tokens, n);
+        }
+    }
+    fclose(in);
+    return true;
+}
+
+void sweep_print_point(const sweep *sw, int point, FILE *out)
+{
+    for (int i = 0; i < sw->n_options[point]; ++i)
+    {
+        fprintf(out, i == 0 ? "%s" : " %s", sw->options[point][i]);
+    }
+}
+
+void sweep_free(sweep *sw)
+{
+    for (int p = 0; p < sw->n_points; ++p)
+    {
+        for (int i = 0; i < sw->n_options[p]; ++i)
+        {
+            free(sw->options[p][i]);
+        }
+        free(sw->options[p]);
+    }
+    free(sw->options);
+    free(sw->n_options);
+}
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions
+
+void sweep_add_point(sweep *sw, char **options, int n)
+{
+    if (sw->n_points == sw->capacity)
+    {
+        sw->capacity *= VECTOR_GROW_RATE;
+        sw->options = (char***)realloc(sw->options, sw->capacity * sizeof(char**));
+        sw->n_options = (int*)realloc(sw->n_options, sw->capacity * sizeof(int));
+    }
+    sw->options[sw->n_points] = (char**)malloc(n * sizeof(char*));
+    for (int i = 0; i < n; ++i)
+    {
+        sw->options[sw->n_points][i] = strdup(options[i]);
+    }
+    sw->n_options[sw->n_points] = n;
+    ++sw->n_points;
+}
+
+int sweep_split(char *line, char **tokens)
+{
+    char *comment = strchr(line, '#');
+    if (comment != NULL)
+    {
+        *comment = '\0';
+    }
+    int n = 0;
+    char *token = strtok(line, " \t\r\n");
+    while (token != NULL && n < SWEEP_MAX_TOKENS)
+    {
+        tokens[n++] = token;
+        token = strtok(NULL, " \t\r\n");
+    }
+    return n;
+}
+
+bool sweep_expand(const char *name, const char *token, char **values, int *n)
+{
+    char buffer[SWEEP_LINE_LENGTH];
+    const char *colon = strchr(token, ':');
+    if (colon == NULL)
+    {
+        if (*n == SWEEP_MAX_TOKENS)
+        {
+            return false;
+        }
+        snprintf(buffer, SWEEP_LINE_LENGTH, "-%s=%s", name, token);
+        values[(*n)++] = strdup(buffer);
+        return true;
+    }
+    // A range from:to:step, both ends included:
+    char *end;
+    const double from = strtod(token, &end);
+    if (end != colon)
+    {
+        return false;
+    }
+    const double to = strtod(colon + 1, &end);
+    if (*end != ':')
+    {
+        return false;
+    }
+    const double step = strtod(end + 1, &end);
+    if (*end != '\0' || step <= 0.0 || to < from)
+    {
+        return false;
+    }
+    // Some tolerance, so 1e-4:1e-3:3e-4 includes 1e-3:
+    const int count = 1 + (int)floor((to - from) / step + 1e-9);
+    for (int i = 0; i < count; ++i)
+    {
+        if (*n == SWEEP_MAX_TOKENS)
+        {
+            return false;
+        }
+        snprintf(buffer, SWEEP_LINE_LENGTH, "-%s=%.10g", name, from + i * step);
+        values[(*n)++] = strdup(buffer);
+    }
+    return true;
+}
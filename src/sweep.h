@@ -0,0 +1,72 @@
+#ifndef SWEEP_H_
+#define SWEEP_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/** Maximum length of a line in a sweep file. */
+#define SWEEP_LINE_LENGTH      4096
+
+/** Maximum number of values (or options) on a line of a sweep file. */
+#define SWEEP_MAX_TOKENS       256
+
+/**
+ * The parameter points of a sweep, each one a list of options of the form
+ * -name=value applied over the options of the command line.
+ *
+ * The points are read from a grid file (sweep_read_grid), one parameter
+ * per line followed by its values, the points being all the combinations
+ * (the last line varying the fastest):
+ *
+ *   mu     1e-5 1e-4 1e-3
+ *   omega  1e-4:1e-3:3e-4
+ *   shape  circle random
+ *
+ * A value 'from:to:step' is expanded to from, from + step, ... up to 'to'.
+ * They can also be read from a job file (sweep_read_jobs), one point per
+ * line written like the command line:
+ *
+ *   -mu=1e-4 -c=20 -shape=star
+ *
+ * In both files, '#' starts a comment and empty lines are ignored.
+ */
+typedef struct
+{
+    char ***options; /** Options of each point. */
+
+    int *n_options; /** Number of options of each point. */
+
+    int n_points; /** Number of points. */
+
+    int capacity; /** Capacity of 'options' and 'n_options'. */
+}
+sweep;
+
+/** Initialize an empty sweep. */
+void sweep_init(sweep *sw);
+
+/** Add the points of a grid file, return false if the file can't be read or a value is invalid. */
+bool sweep_read_grid(sweep *sw, const char *filename);
+
+/** Add the points of a job file, return false if the file can't be read. */
+bool sweep_read_jobs(sweep *sw, const char *filename);
+
+/** Print the options of a point separated by spaces. */
+void sweep_print_point(const sweep *sw, int point, FILE *out);
+
+/** Free the memory. */
+void sweep_free(sweep *sw);
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions. You shouldn't need those.
+
+/** Add a point (copies the options). */
+void sweep_add_point(sweep *sw, char **options, int n);
+
+/** Cut a line into tokens separated by blanks, up to a '#', and return the number of tokens (the line is modified). */
+int sweep_split(char *line, char **tokens);
+
+/** Add the values of a token (a value or a range 'from:to:step') to 'values' in the form -name=value, return false if the range is invalid. */
+bool sweep_expand(const char *name, const char *token, char **values, int *n);
+
+#endif
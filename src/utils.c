@@ -461,6 +461,13 @@ unsigned int devurandom_get_uint()
     return x;
 }
 
+double seconds_monotonic()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
 int compare_float_asc(const void *x, const void *y)
 {
     if (*(float*)x < *(float*)y)
@@ -129,6 +129,9 @@ unsigned int devrandom_get_uint();
 /** Get a non-zero unsigned integer from dev/urandom. */
 unsigned int devurandom_get_uint();
 
+/** Seconds on a monotonic clock (to measure durations). */
+double seconds_monotonic();
+
 /** Compare two 'float' for the qsort function (ascending order). */
 int compare_float_asc(const void *x, const void *y);
 
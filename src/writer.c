@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "utils.h"
+#include "writer.h"
+
+void writer_init(writer *w, int capacity)
+{
+    w->capacity = capacity > 0 ? capacity : 1;
+    w->items = (writer_item*)malloc(w->capacity * sizeof(writer_item));
+    w->first = 0;
+    w->count = 0;
+    w->done = false;
+    w->buffers = 0;
+    w->bytes = 0;
+    w->max_depth = 0;
+    w->total_depth = 0.0;
+    w->waits = 0;
+    w->blocked_seconds = 0.0;
+    w->write_seconds = 0.0;
+    w->failed = 0;
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->not_empty, NULL);
+    pthread_cond_init(&w->not_full, NULL);
+    pthread_create(&w->thread, NULL, writer_thread, (void*)w);
+}
+
+void writer_submit(writer *w, const char *filename, char *data, size_t size, bool append)
+{
+    writer_item item;
+    item.filename = strdup(filename);
+    item.data = data;
+    item.size = size;
+    item.append = append;
+
+    pthread_mutex_lock(&w->lock);
+    if (w->count == w->capacity)
+    {
+        // Back-pressure, the disk is behind:
+        const double t0 = seconds_monotonic();
+        while (w->count == w->capacity)
+        {
+            pthread_cond_wait(&w->not_full, &w->lock);
+        }
+        ++w->waits;
+        w->blocked_seconds += seconds_monotonic() - t0;
+    }
+    w->items[(w->first + w->count) % w->capacity] = item;
+    ++w->count;
+    ++w->buffers;
+    w->total_depth += w->count;
+    if (w->count > w->max_depth)
+    {
+        w->max_depth = w->count;
+    }
+    pthread_cond_signal(&w->not_empty);
+    pthread_mutex_unlock(&w->lock);
+}
+
+FILE *writer_open(writer *w, writer_file *wf, const char *filename, const char *mode)
+{
+    wf->filename = filename != NULL ? strdup(filename) : NULL;
+    wf->data = NULL;
+    wf->size = 0;
+    wf->created = false;
+    if (filename == NULL)
+    {
+        // The output is thrown away:
+        wf->f = fopen("/dev/null", mode);
+    }
+    else
+    {
+        wf->f = w != NULL ? open_memstream(&wf->data, &wf->size) : fopen(filename, mode);
+    }
+    return wf->f;
+}
+
+void writer_flush(writer *w, writer_file *wf)
+{
+    if (w == NULL || wf->filename == NULL)
+    {
+        fflush(wf->f);
+        return;
+    }
+    fflush(wf->f);
+    if (wf->size == 0)
+    {
+        return;
+    }
+    char *data = (char*)malloc(wf->size);
+    memcpy(data, wf->data, wf->size);
+    writer_submit(w, wf->filename, data, wf->size, wf->created);
+    wf->created = true;
+    // The next content starts at the beginning of the buffer:
+    fseek(wf->f, 0, SEEK_SET);
+}
+
+void writer_close(writer *w, writer_file *wf)
+{
+    fclose(wf->f);
+    if (w != NULL && wf->filename != NULL)
+    {
+        // The writer takes the buffer:
+        writer_submit(w, wf->filename, wf->data, wf->size, wf->created);
+    }
+    free(wf->filename);
+}
+
+void writer_print(const writer *w, FILE *out)
+{
+    fprintf(out, "  <writer>\n");
+    fprintf(out, "    <queue>%d</queue>\n", w->capacity);
+    fprintf(out, "    <buffers>%ld</buffers>\n", w->buffers);
+    fprintf(out, "    <bytes>%llu</bytes>\n", w->bytes);
+    fprintf(out, "    <max_depth>%d</max_depth>\n", w->max_depth);
+    fprintf(out, "    <mean_depth>%.2f</mean_depth>\n", w->buffers > 0 ? w->total_depth / w->buffers : 0.0);
+    fprintf(out, "    <waits>%ld</waits>\n", w->waits);
+    fprintf(out, "    <blocked_seconds>%.4f</blocked_seconds>\n", w->blocked_seconds);
+    fprintf(out, "    <write_seconds>%.4f</write_seconds>\n", w->write_seconds);
+    fprintf(out, "    <failed>%d</failed>\n", w->failed);
+    fprintf(out, "  </writer>\n");
+}
+
+void writer_free(writer *w)
+{
+    pthread_mutex_lock(&w->lock);
+    w->done = true;
+    pthread_cond_signal(&w->not_empty);
+    pthread_mutex_unlock(&w->lock);
+    pthread_join(w->thread, NULL);
+    pthread_mutex_destroy(&w->lock);
+    pthread_cond_destroy(&w->not_empty);
+    pthread_cond_destroy(&w->not_full);
+    free(w->items);
+}
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions
+
+void *writer_thread(void *arg)
+{
+    writer *w = (writer*)arg;
+    pthread_mutex_lock(&w->lock);
+    while (true)
+    {
+        while (w->count == 0 && !w->done)
+        {
+            pthread_cond_wait(&w->not_empty, &w->lock);
+        }
+        if (w->count == 0)
+        {
+            break; // Done, and nothing left.
+        }
+        const writer_item item = w->items[w->first];
+        pthread_mutex_unlock(&w->lock);
+
+        // The file system is only touched without the lock:
+        const double t0 = seconds_monotonic();
+        const bool ok = writer_write(&item);
+        const double seconds = seconds_monotonic() - t0;
+        free(item.filename);
+        free(item.data);
+
+        pthread_mutex_lock(&w->lock);
+        // Taken once written, so the depth counts the buffer being written:
+        w->first = (w->first + 1) % w->capacity;
+        --w->count;
+        w->write_seconds += seconds;
+        if (ok)
+        {
+            w->bytes += item.size;
+        }
+        else
+        {
+            ++w->failed;
+        }
+        pthread_cond_signal(&w->not_full);
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+bool writer_write(const writer_item *item)
+{
+    FILE *out = fopen(item->filename, item->append ? "ab" : "wb");
+    if (out == NULL)
+    {
+        return false;
+    }
+    bool ok = fwrite(item->data, 1, item->size, out) == item->size;
+    ok = fclose(out) == 0 && ok;
+    return ok;
+}
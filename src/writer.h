@@ -0,0 +1,119 @@
+#ifndef WRITER_H_
+#define WRITER_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/** A buffer to write to a file. */
+typedef struct
+{
+    char *filename; /** The file. */
+
+    char *data; /** The bytes (owned by the writer once submitted). */
+
+    size_t size; /** Number of bytes. */
+
+    bool append; /** True to add the bytes at the end of the file instead of replacing it. */
+}
+writer_item;
+
+/**
+ * A thread writing the files of the simulations, so the threads running
+ * them hand their output over and start the next job without waiting for
+ * the file system.
+ *
+ * The buffers wait in a queue of 'capacity' buffers, written in the order
+ * they were submitted (so a file can be created and then appended to by
+ * the same simulation). When the queue is full, writer_submit waits: the
+ * time spent waiting, the depth of the queue and the number of bytes
+ * written measure how far the disk is behind the simulations.
+ */
+typedef struct
+{
+    writer_item *items; /** The queue (a ring buffer). */
+
+    int capacity; /** Maximum number of buffers in the queue. */
+
+    int first; /** Index of the oldest buffer. */
+
+    int count; /** Number of buffers in the queue. */
+
+    bool done; /** True once no more buffers will come. */
+
+    pthread_t thread; /** The thread writing the buffers. */
+
+    pthread_mutex_t lock; /** Protects the queue and the statistics. */
+
+    pthread_cond_t not_empty; /** Signaled when a buffer is added. */
+
+    pthread_cond_t not_full; /** Signaled when a buffer is taken. */
+
+    long buffers; /** Number of buffers submitted. */
+
+    unsigned long long bytes; /** Number of bytes written. */
+
+    int max_depth; /** Largest number of buffers in the queue. */
+
+    double total_depth; /** Sum of the depths when the buffers were submitted. */
+
+    long waits; /** Number of submissions that waited for room in the queue. */
+
+    double blocked_seconds; /** Time the simulations waited for room in the queue. */
+
+    double write_seconds; /** Time spent by the thread writing. */
+
+    int failed; /** Number of buffers that couldn't be written. */
+}
+writer;
+
+/** A file written through a writer, or directly if the writer is NULL. */
+typedef struct
+{
+    FILE *f; /** Where the output is printed. */
+
+    char *filename; /** Name of the file. */
+
+    char *data; /** The output, with a writer. */
+
+    size_t size; /** Size of 'data'. */
+
+    bool created; /** True once a part of the content was handed to the writer. */
+}
+writer_file;
+
+/** Initialize the queue and start the thread. */
+void writer_init(writer *w, int capacity);
+
+/** Queue 'size' bytes of 'data' (the writer frees it) for 'filename', waiting if the queue is full. */
+void writer_submit(writer *w, const char *filename, char *data, size_t size, bool append);
+
+/**
+ * Open a file: a buffer in memory with a writer, the file itself without
+ * (w = NULL). A NULL 'filename' throws the output away. Return NULL on
+ * failure.
+ */
+FILE *writer_open(writer *w, writer_file *wf, const char *filename, const char *mode);
+
+/** Hand the content printed since the last call to the writer, appended to the file (nothing without a writer). */
+void writer_flush(writer *w, writer_file *wf);
+
+/** Close a file opened by writer_open (the rest of its content goes to the writer). */
+void writer_close(writer *w, writer_file *wf);
+
+/** Print the statistics of the queue. */
+void writer_print(const writer *w, FILE *out);
+
+/** Write the buffers left, stop the thread and free the memory. */
+void writer_free(writer *w);
+
+///////////////////////////////////////////////////////////////
+// 'Private' functions. You shouldn't need those.
+
+/** Main function of the thread ('arg' points to the writer). */
+void *writer_thread(void *arg);
+
+/** Write a buffer to its file, return false on failure. */
+bool writer_write(const writer_item *item);
+
+#endif
@@ -0,0 +1,30 @@
+# Replicates branching from a burn-in, with -converge: the window only counts
+# the groups of 1000 generations each replicate simulated itself, so none can
+# stop before the end of the burn-in plus the window. Run with
+# -DORIGIN=<executable> -DOUTPUT=<directory>.
+set(burnin 10)
+set(window 6)
+execute_process(COMMAND ${ORIGIN} -c=6 -jpc=200 -g=30 -burnin=${burnin} -converge=${window} -tolerance=0.5 -x=4 -seed=5 -o=${OUTPUT}/burnin_converge
+                RESULT_VARIABLE status OUTPUT_QUIET)
+if(NOT status EQUAL 0)
+  message(FATAL_ERROR "origin failed (${status})")
+endif()
+
+foreach(seed 5 6 7 8)
+  file(READ ${OUTPUT}/burnin_converge${seed}.xml xml)
+  string(REGEX MATCH "<burnin_k>([0-9]+)</burnin_k>" found "${xml}")
+  if(NOT found OR NOT CMAKE_MATCH_1 EQUAL burnin)
+    message(FATAL_ERROR "replicate ${seed} didn't branch from the burn-in")
+  endif()
+  if(NOT xml MATCHES "<convergence>")
+    message(FATAL_ERROR "replicate ${seed} didn't check its convergence")
+  endif()
+  string(REGEX MATCH "<stopped_at_k>([0-9]+)</stopped_at_k>" found "${xml}")
+  if(found)
+    math(EXPR own "${CMAKE_MATCH_1} - ${burnin}")
+    if(own LESS window)
+      message(FATAL_ERROR "replicate ${seed} stopped after ${own} groups of its own, fewer than the window (${window})")
+    endif()
+  endif()
+  message(STATUS "replicate ${seed}: ok")
+endforeach()
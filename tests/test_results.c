@@ -0,0 +1,201 @@
+// Checks of the binary output (-format=1): the XML converted back from it is
+// the XML output, the reader gives back the parameters and the columns
+// without the XML, and the streamed series of a simulation cut short are
+// recovered. Returns 0 if every check passes.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "results.h"
+
+#define XML_FILE          "test_results.xml"
+#define BIN_FILE          "test_results.bin"
+#define CONVERTED_FILE    "test_results-converted.xml"
+#define VERTICES          5
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+    {
+        ++failures;
+    }
+}
+
+// The content of a file (NULL if it can't be read), its size in 'size'.
+static char *read_file(const char *filename, long *size)
+{
+    FILE *f = fopen(filename, "rb");
+    if (f == NULL)
+    {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *data = (char*)malloc(*size + 1);
+    *size = (long)fread(data, 1, *size, f);
+    data[*size] = '\0';
+    fclose(f);
+    return data;
+}
+
+// A small output shaped like the one of a simulation.
+static void write_output(const char *filename, int format)
+{
+    results r;
+    results_open(&r, filename, format, NULL);
+    fprintf(r.out, "<?xml version=\"1.0\"?>\n<simulation>\n");
+    results_param_text(&r, 2, "model", "Neutral BDM speciation");
+    results_param_int(&r, 2, "seed", 4000000000u);
+    results_param_real(&r, 2, "mutation_rate", 1e-4, 'e', 2);
+    results_param_real(&r, 2, "radius", 0.25, 'f', 4);
+
+    const int series[6] = { 3, 0, 120, 400, 70000, 2 };
+    for (int k = 0; k < 6; ++k)
+    {
+        results_stream_ints(&r, "global/extant_species_per_k_gen", series, k + 1);
+    }
+    fprintf(r.out, "  <global>\n");
+    results_real(&r, 4, "global/links_per_c", 2.0 / 3.0, 4);
+    results_ints(&r, 4, "global/extant_species_per_k_gen", series, 6);
+    fprintf(r.out, "  </global>\n");
+    for (int c = 0; c < VERTICES; ++c)
+    {
+        int distribution[VERTICES];
+        double octaves[VERTICES];
+        for (int i = 0; i < c; ++i)
+        {
+            distribution[i] = i - 1;
+            octaves[i] = 0.5 * i;
+        }
+        fprintf(r.out, "  <vertex>\n");
+        results_int(&r, 4, "vertex/id", c);
+        results_ints(&r, 4, "vertex/species_distribution", distribution, c);
+        results_reals(&r, 4, "vertex/octaves", octaves, c, 2);
+        fprintf(r.out, "  </vertex>\n");
+    }
+    fprintf(r.out, "</simulation>\n");
+    results_close(&r);
+}
+
+// The XML of the binary file is the XML output, and the binary file is smaller.
+static void test_convert()
+{
+    write_output(XML_FILE, RESULTS_XML);
+    write_output(BIN_FILE, RESULTS_BINARY);
+    FILE *out = fopen(CONVERTED_FILE, "w");
+    const bool converted = results_to_xml(BIN_FILE, out);
+    fclose(out);
+    check(converted, "the binary file converts to XML");
+
+    long xml_size = 0, bin_size = 0, converted_size = 0;
+    char *xml = read_file(XML_FILE, &xml_size);
+    char *bin = read_file(BIN_FILE, &bin_size);
+    char *conv = read_file(CONVERTED_FILE, &converted_size);
+    check(xml != NULL && conv != NULL && xml_size == converted_size && memcmp(xml, conv, xml_size) == 0, "same XML");
+    char what[200];
+    sprintf(what, "%ld bytes in binary, %ld in XML", bin_size, xml_size);
+    check(bin != NULL && bin_size < xml_size, what);
+    free(xml);
+    free(bin);
+    free(conv);
+}
+
+// The parameters and the columns read without the XML.
+static void test_reader()
+{
+    results_file rf;
+    check(results_file_open(&rf, BIN_FILE) && rf.complete, "the binary file opens");
+
+    const results_field *p = results_file_param(&rf, "seed");
+    check(p != NULL && p->type == RESULTS_INT && p->i == 4000000000l, "int parameter");
+    p = results_file_param(&rf, "mutation_rate");
+    check(p != NULL && p->type == RESULTS_REAL && p->x == 1e-4 && p->notation == 'e', "real parameter");
+    p = results_file_param(&rf, "model");
+    check(p != NULL && p->type == RESULTS_TEXT && strcmp(p->text, "Neutral BDM speciation") == 0, "text parameter");
+    check(results_file_param(&rf, "omega") == NULL && results_file_column(&rf, "octaves") == NULL, "missing names");
+
+    const results_field *col = results_file_column(&rf, "global/extant_species_per_k_gen");
+    int series[6] = { 0 };
+    if (col != NULL && col->size == 6)
+    {
+        results_field_ints(col, series);
+    }
+    check(col != NULL && col->bytes == 4 && series[0] == 3 && series[4] == 70000 && series[5] == 2, "int column");
+
+    col = results_file_column(&rf, "global/links_per_c");
+    check(col != NULL && col->size == 1 && col->bytes == 8 && ((const double*)col->values)[0] == 2.0 / 3.0, "real column");
+
+    col = results_file_column(&rf, "vertex/id");
+    bool ok = col != NULL && col->size == VERTICES && col->parts == VERTICES && col->bytes == 1;
+    for (int c = 0; ok && c < VERTICES; ++c)
+    {
+        ok = ((const int*)col->values)[c] == c && col->part_sizes[c] == 1;
+    }
+    check(ok, "one value per vertex");
+
+    // Vertex c has c values, from -1 up:
+    col = results_file_column(&rf, "vertex/species_distribution");
+    ok = col != NULL && col->size == VERTICES * (VERTICES - 1) / 2 && col->parts == VERTICES;
+    for (int c = 0, first = 0; ok && c < VERTICES; first += c++)
+    {
+        ok = col->part_sizes[c] == c;
+        for (int i = 0; ok && i < c; ++i)
+        {
+            ok = ((const int*)col->values)[first + i] == i - 1;
+        }
+    }
+    check(ok, "parts of different sizes, negative values");
+
+    col = results_file_column(&rf, "vertex/octaves");
+    double octaves[VERTICES * (VERTICES - 1) / 2] = { 0.0 };
+    if (col != NULL && col->size == VERTICES * (VERTICES - 1) / 2)
+    {
+        results_field_reals(col, octaves);
+    }
+    check(col != NULL && col->bytes == 4 && octaves[1] == 0.0 && octaves[9] == 1.5, "reals held exactly on 4 bytes");
+    results_file_close(&rf);
+}
+
+// The streamed series of a simulation that didn't finish.
+static void test_recover()
+{
+    results r;
+    results_open(&r, BIN_FILE, RESULTS_BINARY, NULL);
+    results_param_int(&r, 2, "seed", 1);
+    const int series[3] = { 5, 6, 7 };
+    results_stream_ints(&r, "global/speciation_per_k_gen", series, 2);
+    results_stream_ints(&r, "global/extinctions_per_k_gen", series, 1);
+    results_stream_ints(&r, "global/speciation_per_k_gen", series, 3);
+
+    // As if the simulation crashed here:
+    results_file rf;
+    check(results_file_open(&rf, BIN_FILE) && !rf.complete && rf.n_params == 0, "the file cut short opens");
+    const results_field *col = results_file_column(&rf, "global/speciation_per_k_gen");
+    check(col != NULL && col->size == 3 && ((const int*)col->values)[2] == 7, "streamed series recovered");
+    col = results_file_column(&rf, "global/extinctions_per_k_gen");
+    check(col != NULL && col->size == 1 && ((const int*)col->values)[0] == 5, "second streamed series recovered");
+    results_file_close(&rf);
+    FILE *out = fopen(CONVERTED_FILE, "w");
+    check(!results_to_xml(BIN_FILE, out), "the file cut short is reported");
+    fclose(out);
+
+    results_close(&r);
+    check(results_file_open(&rf, BIN_FILE) && rf.complete && rf.n_params == 1, "complete once closed");
+    results_file_close(&rf);
+}
+
+int main()
+{
+    test_convert();
+    test_reader();
+    test_recover();
+    remove(XML_FILE);
+    remove(BIN_FILE);
+    remove(CONVERTED_FILE);
+    printf("%d failure(s)\n", failures);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,80 @@
+// Known answers of the Philox4x32-10 backend (-rng=2): the block function
+// against the test vectors of its authors (Salmon et al., Random123), and
+// the buffered stream against the block function. Returns 0 if every check
+// passes.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "rng.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+    {
+        ++failures;
+    }
+}
+
+// The test vectors of Random123 (kat_vectors, philox4x32 with 10 rounds).
+static void test_known_answers()
+{
+    const uint32_t ctr[3][4] =
+    {
+        { 0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+        { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff },
+        { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }
+    };
+    const uint32_t key[3][2] =
+    {
+        { 0x00000000, 0x00000000 },
+        { 0xffffffff, 0xffffffff },
+        { 0xa4093822, 0x299f31d0 }
+    };
+    const uint32_t expected[3][4] =
+    {
+        { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 },
+        { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd },
+        { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 }
+    };
+    for (int v = 0; v < 3; ++v)
+    {
+        uint32_t out[4];
+        rng_philox4x32(ctr[v], key[v], out);
+        char what[200];
+        sprintf(what, "vector %d: %08x %08x %08x %08x", v, out[0], out[1], out[2], out[3]);
+        check(out[0] == expected[v][0] && out[1] == expected[v][1] && out[2] == expected[v][2] && out[3] == expected[v][3], what);
+    }
+}
+
+// Block 'b' of the substream 's' gives the words 2b and 2b + 1 of the stream.
+static void test_stream()
+{
+    const uint32_t seed = 12345, replicate = 7, substream = 3;
+    rng_stream r;
+    rng_stream_init_philox(&r, seed, replicate, substream);
+    const uint32_t key[2] = { seed, replicate };
+    bool ok = true;
+    // Over several refills of the buffer:
+    for (uint32_t b = 0; ok && b < 3 * RNG_BUFFER_SIZE; ++b)
+    {
+        const uint32_t ctr[4] = { b, 0, substream, 0 };
+        uint32_t out[4];
+        rng_philox4x32(ctr, key, out);
+        const uint64_t first = rng_stream_next(&r);
+        const uint64_t second = rng_stream_next(&r);
+        ok = first == (((uint64_t)out[1] << 32) | out[0]) && second == (((uint64_t)out[3] << 32) | out[2]);
+    }
+    check(ok, "the stream is the sequence of the blocks of its substream");
+}
+
+int main()
+{
+    test_known_answers();
+    test_stream();
+    printf("%d failure(s)\n", failures);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,233 @@
+// Statistical checks of the skip-ahead (-skip=1) of the forward engine: the
+// countdowns must give the same process as one Bernoulli draw per event, and
+// never fire when the event can't happen (one community, omega = 0, mu = 0).
+// Returns 0 if every check passes.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <math.h>
+#include "ivector.h"
+#include "rng.h"
+#include "graph.h"
+#include "migration.h"
+#include "species.h"
+#include "specieslist.h"
+#include "kernel.h"
+#include "forward.h"
+
+#define INIT_SPECIES      10
+#define J_PER_C           40
+#define REPLICATES        30
+// Isolated enough communities and a high rate, for a few species per run:
+#define OMEGA             0.01
+#define MU                0.05
+
+// Totals of one run.
+typedef struct
+{
+    long migrations;
+    double expected_migrations;
+    long mutation_trials;
+    long mutations;
+    int speciations;
+    int richness;
+}
+run_stats;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+    {
+        ++failures;
+    }
+}
+
+// One run of the forward engine on a circle of 'communities'.
+static run_stats run(int state, bool skip, int communities, double omega, double mu, unsigned int seed, int k_gen)
+{
+    graph g;
+    graph_get_circle(&g, communities);
+    graph_csr csr;
+    graph_csr_init(&csr, &g);
+    graph_free(&g);
+    migration_sampler ms;
+    migration_sampler_init(&ms, &csr, omega);
+
+    rng_stream *community_rng = (rng_stream*)malloc(communities * sizeof(rng_stream));
+    rng_stream **rngs = (rng_stream**)malloc(communities * sizeof(rng_stream*));
+    for (int c = 0; c < communities; ++c)
+    {
+        rng_stream_init_philox(&community_rng[c], seed, 0, 1 + c);
+        rngs[c] = &community_rng[c];
+    }
+
+    species_list *list = species_list_init();
+    for (int i = 0; i < INIT_SPECIES; ++i)
+    {
+        species *sp = species_init(communities, 0, 3);
+        for (int c = 0; c < communities; ++c)
+        {
+            sp->n[c] = J_PER_C / INIT_SPECIES;
+            sp->genotypes[0][c] = J_PER_C / INIT_SPECIES;
+            sp->total += J_PER_C / INIT_SPECIES;
+        }
+        species_list_add(list, sp);
+    }
+
+    int *speciation_events = (int*)calloc(k_gen, sizeof(int));
+    int *extinction_events = (int*)calloc(k_gen, sizeof(int));
+    int *total_species = (int*)calloc(k_gen, sizeof(int));
+    int *speciation_per_c = (int*)calloc(communities, sizeof(int));
+    int *extinction_per_c = (int*)calloc(communities, sizeof(int));
+    ivector lifespan, pop_size;
+    ivector_init0(&lifespan);
+    ivector_init0(&pop_size);
+
+    forward fw;
+    forward_init(&fw, MODEL_BDM_NEUTRAL, state, SAMPLER_FENWICK, MIGRATION_ALIAS, skip, omega, list, &csr, &ms, NULL, rngs, J_PER_C, mu, 0.0);
+    forward_set_stats(&fw, speciation_events, extinction_events, total_species, speciation_per_c, extinction_per_c, &lifespan, &pop_size);
+    for (int k = 0; k < k_gen; ++k)
+    {
+        forward_run_k(&fw, k);
+    }
+
+    run_stats rs;
+    rs.migrations = fw.migrations;
+    rs.expected_migrations = fw.expected_migrations;
+    rs.mutation_trials = fw.mutation_trials;
+    rs.mutations = fw.mutations;
+    rs.speciations = 0;
+    for (int k = 0; k < k_gen; ++k)
+    {
+        rs.speciations += speciation_events[k];
+    }
+    rs.richness = total_species[k_gen - 1];
+
+    forward_free(&fw);
+    species_list_free(list);
+    ivector_free(&lifespan);
+    ivector_free(&pop_size);
+    free(speciation_events);
+    free(extinction_events);
+    free(total_species);
+    free(speciation_per_c);
+    free(extinction_per_c);
+    free(rngs);
+    free(community_rng);
+    migration_sampler_free(&ms);
+    graph_csr_free(&csr);
+    return rs;
+}
+
+// Welch's t statistic of two samples.
+static double welch_t(const double *a, const double *b, int n)
+{
+    double mean_a = 0.0, mean_b = 0.0;
+    for (int i = 0; i < n; ++i)
+    {
+        mean_a += a[i] / n;
+        mean_b += b[i] / n;
+    }
+    double var_a = 0.0, var_b = 0.0;
+    for (int i = 0; i < n; ++i)
+    {
+        var_a += (a[i] - mean_a) * (a[i] - mean_a) / (n - 1);
+        var_b += (b[i] - mean_b) * (b[i] - mean_b) / (n - 1);
+    }
+    const double se = sqrt(var_a / n + var_b / n);
+    return se > 0.0 ? (mean_a - mean_b) / se : 0.0;
+}
+
+// The skip-ahead and the per-event draws give the same distributions.
+static void test_same_process(int state)
+{
+    double richness[2][REPLICATES];
+    double speciations[2][REPLICATES];
+    for (int skip = 0; skip < 2; ++skip)
+    {
+        long migrations = 0, mutation_trials = 0, mutations = 0;
+        double expected_migrations = 0.0;
+        for (int r = 0; r < REPLICATES; ++r)
+        {
+            const run_stats rs = run(state, skip, 8, OMEGA, MU, 1000 * skip + r + 1, 1);
+            migrations += rs.migrations;
+            expected_migrations += rs.expected_migrations;
+            mutation_trials += rs.mutation_trials;
+            mutations += rs.mutations;
+            richness[skip][r] = rs.richness;
+            speciations[skip][r] = rs.speciations;
+        }
+        const double expected_mutations = mutation_trials * MU;
+        char what[200];
+        sprintf(what, "state %d, skip %d: %ld migrations for %.0f expected", state, skip, migrations, expected_migrations);
+        check(fabs(migrations - expected_migrations) < 5.0 * sqrt(expected_migrations), what);
+        sprintf(what, "state %d, skip %d: %ld mutations for %.0f expected", state, skip, mutations, expected_mutations);
+        check(fabs(mutations - expected_mutations) < 5.0 * sqrt(expected_mutations), what);
+    }
+    char what[200];
+    const double t_richness = welch_t(richness[0], richness[1], REPLICATES);
+    sprintf(what, "state %d: same richness with and without skip-ahead (t = %.2f)", state, t_richness);
+    check(fabs(t_richness) < 4.0, what);
+    const double t_speciations = welch_t(speciations[0], speciations[1], REPLICATES);
+    sprintf(what, "state %d: same speciations with and without skip-ahead (t = %.2f)", state, t_speciations);
+    check(fabs(t_speciations) < 4.0, what);
+}
+
+// The events that can't happen never do.
+static void test_never(int state)
+{
+    char what[200];
+    run_stats rs = run(state, true, 1, OMEGA, MU, 7, 1);
+    sprintf(what, "state %d, one community: %ld migrations", state, rs.migrations);
+    check(rs.migrations == 0 && rs.mutations > 0, what);
+
+    rs = run(state, true, 8, 0.0, MU, 7, 1);
+    sprintf(what, "state %d, omega = 0: %ld migrations", state, rs.migrations);
+    check(rs.migrations == 0 && rs.mutations > 0, what);
+
+    rs = run(state, true, 8, OMEGA, 0.0, 7, 1);
+    sprintf(what, "state %d, mu = 0: %ld mutations, %d speciations", state, rs.mutations, rs.speciations);
+    check(rs.mutations == 0 && rs.speciations == 0 && rs.migrations > 0, what);
+}
+
+// The countdowns: 0 for 'p' = 0, and no cap on the tail of a tiny 'p'.
+static void test_geometric()
+{
+    rng_stream r;
+    rng_stream_init_philox(&r, 11, 0, 0);
+    check(rng_stream_geometric(&r, 0.0) == 0, "geometric(0) never succeeds");
+    check(rng_stream_geometric(&r, 1.0) == 1, "geometric(1) succeeds at once");
+
+    const double p = 1e-12;
+    const int n = 2000;
+    double mean = 0.0;
+    int beyond_int = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        const int64_t x = rng_stream_geometric(&r, p);
+        mean += (double)x / n;
+        if (x > INT_MAX)
+        {
+            ++beyond_int;
+        }
+    }
+    char what[200];
+    sprintf(what, "geometric(1e-12): mean %.3g, %d of %d draws beyond INT_MAX", mean, beyond_int, n);
+    check(fabs(mean * p - 1.0) < 0.15 && beyond_int > n * 9 / 10, what);
+}
+
+int main()
+{
+    test_geometric();
+    test_same_process(STATE_LIST);
+    test_same_process(STATE_DENSE);
+    test_never(STATE_LIST);
+    test_never(STATE_DENSE);
+    printf("%d failure(s)\n", failures);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}